@@ -6,6 +6,7 @@
 
 #include <PhysicsEngine2D/Simulator.hpp>
 #include <PhysicsEngine2D/Vector2D.hpp>
+#include <PhysicsEngine2D/util.hpp>
 #include <array>
 #include <filesystem>
 #include <string>
@@ -22,8 +23,6 @@ struct ViewPort {
 	dataType rel(dataType);
 };
 
-void print_exception(const std::exception& e, int level = 0);
-
 using Color = ImColor;
 
 class DrawUtil {
@@ -9,11 +9,13 @@
 #endif
 
 #include <PhysicsEngine2D/Simulator.hpp>
+#include <PhysicsEngine2D/Trajectory.hpp>
 #include <PhysicsEngine2D/util.hpp>
 #include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <random>
 #include <set>
 
@@ -65,6 +67,46 @@ GLFWwindow* setupWindow(const ViewPort& view, const std::string& title) {
 	return window;
 }
 
+/**
+ * Draws dynamic shapes of a recorded frame
+ */
+static void drawFrame(
+	ImDrawList* dl, DrawUtil& drawUtil, const TrajectoryFrame& frame,
+	bool showVelocity) {
+	const auto& f = frame.fields;
+	const size_t balls = frame.particles + frame.balls;
+	for (size_t i = 0; i < frame.size(); i++) {
+		const Vector2D pos(f[POS_X][i], f[POS_Y][i]);
+		if (showVelocity) {
+			drawUtil.line(
+				dl, pos, pos + Vector2D(f[VEL_X][i], f[VEL_Y][i]),
+				ImColor(1.0f, 1.0f, 1.0f));
+		}
+		const auto radiusVec =
+			Vector2D(std::cos(f[ANGLE][i]), std::sin(f[ANGLE][i]));
+		if (i < balls) {
+			drawUtil.drawCircle(
+				dl, pos, f[SIZE_X][i], ImColor(0.0f, 0.0f, 1.0f));
+			if (i >= frame.particles) {
+				drawUtil.line(
+					dl, pos, pos + f[SIZE_X][i] * radiusVec,
+					ImColor(1.0f, 1.0f, 0.0f));
+			}
+			continue;
+		}
+		const auto first = 0.5 * Vector2D(f[SIZE_X][i], f[SIZE_Y][i])
+									 .rotate(radiusVec.y, radiusVec.x),
+				   second = 0.5 * Vector2D(-f[SIZE_X][i], f[SIZE_Y][i])
+									  .rotate(radiusVec.y, radiusVec.x);
+		const Vector2D corners[] = {
+			pos + first, pos + second, pos - first, pos - second};
+		for (int c = 0; c < 4; c++) {
+			drawUtil.line(
+				dl, corners[c], corners[(c + 1) % 4], ImColor(0.0f, 0.0f, 1.0f));
+		}
+	}
+}
+
 int main(int argc, char** argv) {
 	std::vector<std::string> args;
 	for (int i = 0; i < argc; i++) {
@@ -82,8 +124,32 @@ int main(int argc, char** argv) {
 
 	DrawUtil drawUtil(initFilePath, sim);
 
+	// Optional recorded trajectory is played back over the lines of the
+	// scene instead of simulating, only the shown frame is decoded
+	std::unique_ptr<TrajectoryReader> trajectory;
+	if (args.size() > 2) {
+		try {
+			trajectory = std::make_unique<TrajectoryReader>(
+				std::filesystem::absolute(std::filesystem::path(args[2])));
+		}
+		catch (const std::exception& e) {
+			print_exception(e);
+			return -1;
+		}
+		if (trajectory->getFrameCount() == 0) {
+			std::cerr << "Trajectory has no frames\n";
+			return -1;
+		}
+	}
+	TrajectoryFrame frame, decoded;
+	int frameIndex = 0, shownFrame = -1;
+	float playbackRate = 60;
+	double playbackPosition = 0;
+
 	bool showBox = false;
 	bool pauseSimulation = false;
+	bool recordTrace = false;
+	TraceRecorder traceRecorder;
 	double time = 0, lastTime = glfwGetTime();
 
 	auto window = setupWindow(drawUtil.view, drawUtil.title);
@@ -100,7 +166,38 @@ int main(int argc, char** argv) {
 			auto timeLapsed = std::min(now - lastTime, 0.1);
 			time += timeLapsed;
 			lastTime = now;
-			sim.simulate(timeLapsed);
+			if (trajectory) {
+				playbackPosition = std::min<double>(
+					playbackPosition + playbackRate * timeLapsed,
+					trajectory->getFrameCount() - 1);
+				frameIndex = static_cast<int>(playbackPosition);
+			}
+			else {
+				sim.simulate(timeLapsed);
+			}
+		}
+		else {
+			lastTime = glfwGetTime();
+		}
+		if (trajectory && frameIndex != shownFrame) {
+			// Chunks are only checked when read, a corrupt one stops
+			// playback at the last good frame. Frames are decoded as deltas
+			// of the previous one, so decoded is kept across reads.
+			try {
+				trajectory->readFrame(frameIndex, decoded);
+				frame = decoded;
+				shownFrame = frameIndex;
+			}
+			catch (const std::exception& e) {
+				print_exception(e);
+				pauseSimulation = true;
+				if (shownFrame >= 0) {
+					playbackPosition = frameIndex = shownFrame;
+				}
+				else {
+					shownFrame = frameIndex;
+				}
+			}
 		}
 
 		// Start the Dear ImGui frame
@@ -114,22 +211,73 @@ int main(int argc, char** argv) {
 			1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 		if (ImGui::Button("Reset")) {
 			time = 0;
+			playbackPosition = frameIndex = 0;
 			drawUtil = DrawUtil(initFilePath, sim);
 		}
 		ImGui::Checkbox("Show Bounding Boxes", &showBox);
 		ImGui::Checkbox("Pause Simulation", &pauseSimulation);
-		ImGui::SliderFloat(
-			"N Body Gravity", &sim.nBodyGravity, 0, 100, nullptr,
-			ImGuiSliderFlags_Logarithmic);
-		ImGui::SliderFloat("Coefficient of Friction", &sim.frictionCoeff, 0, 1);
-		ImGui::SliderFloat(
-			"Coefficient of Restitution", &sim.restitutionCoeff, 0, 1);
+		if (trajectory) {
+			ImGui::Text(
+				"Step %llu, %.2f secs, %u bodies",
+				static_cast<unsigned long long>(frame.step), frame.time,
+				static_cast<unsigned>(frame.size()));
+			if (ImGui::SliderInt(
+					"Frame", &frameIndex, 0,
+					static_cast<int>(trajectory->getFrameCount()) - 1)) {
+				playbackPosition = frameIndex;
+			}
+			ImGui::SliderFloat(
+				"Frames/s", &playbackRate, 1, 1000, nullptr,
+				ImGuiSliderFlags_Logarithmic);
+		}
+		else {
+			ImGui::SliderFloat(
+				"N Body Gravity", &sim.nBodyGravity, 0, 100, nullptr,
+				ImGuiSliderFlags_Logarithmic);
+			ImGui::SliderFloat(
+				"Coefficient of Friction", &sim.frictionCoeff, 0, 1);
+			ImGui::SliderFloat(
+				"Coefficient of Restitution", &sim.restitutionCoeff, 0, 1);
+		}
 
 		ImGui::End();
 
+		const auto& stats = sim.getStats();
+		ImGui::Begin("Profiler", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+		ImGui::Text(
+			"Step: %.3f ms in %zu substeps", 1000 * stats.totalTime(),
+			stats.subStepSeconds.size());
+		for (int phase = 0; phase < PHASE_COUNT; phase++) {
+			const double seconds = stats.totalSeconds[phase];
+			const auto label = std::to_string(1000 * seconds) + " ms";
+			ImGui::ProgressBar(
+				stats.totalTime() > 0 ? seconds / stats.totalTime() : 0,
+				ImVec2(200, 0), label.c_str());
+			ImGui::SameLine();
+			ImGui::Text("%s", getPhaseName(SimulationPhase(phase)));
+		}
+		ImGui::Separator();
+		ImGui::Text("Candidate Pairs: %zu", stats.candidatePairs);
+		ImGui::Text("Contacts: %zu", stats.contacts);
+		ImGui::Text("Impulses: %zu", stats.impulses);
+		ImGui::Text("Frame Arena: %.1f KiB", stats.frameBytes / 1024.0);
+		ImGui::Text("Spawned: %zu, Expired: %zu", stats.spawned, stats.expired);
+		ImGui::Separator();
+		if (ImGui::Checkbox("Record Trace", &recordTrace)) {
+			sim.setTraceRecorder(recordTrace ? &traceRecorder : nullptr);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Save Trace")) {
+			std::ofstream traceFile(rootPath / "trace.json");
+			traceRecorder.writeChromeTrace(traceFile);
+			traceRecorder.clear();
+		}
+		ImGui::End();
+
 		auto dl = ImGui::GetBackgroundDrawList();
+		// Bodies of the scene are not simulated while a trajectory plays
 		for (auto& elem : sim.getBaseShapes()) {
-			if (showBox)
+			if (showBox && !trajectory)
 				drawUtil.rect(
 					dl, {elem.get().left, elem.get().top},
 					{elem.get().right, elem.get().bottom},
@@ -146,6 +294,21 @@ int main(int argc, char** argv) {
 			}
 		}
 
+		for (auto& chain : sim.getChains()) {
+			const auto& vertices = chain.getVertices();
+			for (size_t i = 0; i + 1 < vertices.size(); i++) {
+				drawUtil.line(
+					dl, vertices[i], vertices[i + 1],
+					ImColor(0.0f, 1.0f, 0.0f));
+			}
+		}
+
+		if (trajectory) {
+			drawFrame(dl, drawUtil, frame, showBox);
+			drawUtil.finally(window);
+			continue;
+		}
+
 		for (auto& particle : sim.getParticles()) {
 			drawUtil.drawCircle(
 				dl, particle.pos, particle.rad, ImColor(0.0f, 0.0f, 1.0f));
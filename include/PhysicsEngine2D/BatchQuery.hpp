@@ -0,0 +1,157 @@
+#ifndef BATCH_QUERY_HPP
+#define BATCH_QUERY_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "Range.hpp"
+#include "Vector2D.hpp"
+
+/**
+ * Results of a batch of range queries stored in CSR form, values inside
+ * query i are values[offsets[i], offsets[i + 1])
+ */
+template <class ValueType> struct BatchQueryResult {
+	std::vector<size_t> offsets;
+	std::vector<ValueType> values;
+
+	inline size_t size() const {
+		return offsets.empty() ? 0 : offsets.size() - 1;
+	}
+	inline size_t count(size_t i) const { return offsets[i + 1] - offsets[i]; }
+	inline const ValueType* begin(size_t i) const {
+		return values.data() + offsets[i];
+	}
+	inline const ValueType* end(size_t i) const {
+		return values.data() + offsets[i + 1];
+	}
+};
+
+inline uint32_t spreadBits(uint32_t x) {
+	x &= 0x0000ffff;
+	x = (x | (x << 8)) & 0x00ff00ff;
+	x = (x | (x << 4)) & 0x0f0f0f0f;
+	x = (x | (x << 2)) & 0x33333333;
+	x = (x | (x << 1)) & 0x55555555;
+	return x;
+}
+
+inline uint32_t mortonCode(uint32_t x, uint32_t y) {
+	return spreadBits(x) | (spreadBits(y) << 1);
+}
+
+/**
+ * Returns indices of queries sorted by Morton code of their centers, so
+ * that neighbouring queries touch the same parts of a tree
+ */
+inline std::vector<int> getMortonOrder(
+	const std::vector<Range2D<dataType>>& queries) {
+	std::vector<int> order(queries.size());
+	std::iota(order.begin(), order.end(), 0);
+	if (queries.empty()) {
+		return order;
+	}
+
+	std::vector<Vector2D> centers;
+	centers.reserve(queries.size());
+	Vector2D low(
+		std::numeric_limits<dataType>::max(),
+		std::numeric_limits<dataType>::max()),
+		high(
+			std::numeric_limits<dataType>::lowest(),
+			std::numeric_limits<dataType>::lowest());
+	for (auto& query : queries) {
+		centers.emplace_back(
+			0.5f * (query.rangeX.start + query.rangeX.end),
+			0.5f * (query.rangeY.start + query.rangeY.end));
+		low.x = std::min(low.x, centers.back().x);
+		low.y = std::min(low.y, centers.back().y);
+		high.x = std::max(high.x, centers.back().x);
+		high.y = std::max(high.y, centers.back().y);
+	}
+
+	const dataType scaleX = high.x > low.x ? 65535 / (high.x - low.x) : 0,
+				   scaleY = high.y > low.y ? 65535 / (high.y - low.y) : 0;
+	std::vector<uint32_t> codes(queries.size());
+	for (size_t i = 0; i < queries.size(); i++) {
+		codes[i] = mortonCode(
+			(centers[i].x - low.x) * scaleX, (centers[i].y - low.y) * scaleY);
+	}
+	std::sort(order.begin(), order.end(), [&codes](int a, int b) {
+		return comparePair(codes[a], codes[b], a < b);
+	});
+	return order;
+}
+
+/**
+ * Runs every query in Morton order, split among threads.
+ * @param queries ranges to query
+ * @param query callable (range, std::vector<ValueType>&) appending values
+ * inside range to the vector, must be safe to call concurrently
+ * @return results in order of queries
+ */
+template <class ValueType, class Query>
+BatchQueryResult<ValueType> batchRangeQuery(
+	const std::vector<Range2D<dataType>>& queries, const Query& query) {
+	static const size_t MIN_QUERIES_PER_THREAD = 64;
+
+	BatchQueryResult<ValueType> result;
+	result.offsets.assign(queries.size() + 1, 0);
+	if (queries.empty()) {
+		return result;
+	}
+
+	const auto order = getMortonOrder(queries);
+	const size_t threads = std::max<size_t>(
+		1, std::min<size_t>(
+			   std::thread::hardware_concurrency(),
+			   queries.size() / MIN_QUERIES_PER_THREAD));
+
+	std::vector<std::vector<ValueType>> localValues(threads);
+	auto chunkStart = [&](size_t t) { return queries.size() * t / threads; };
+
+	auto runChunk = [&](size_t t) {
+		auto& values = localValues[t];
+		for (size_t p = chunkStart(t); p < chunkStart(t + 1); p++) {
+			const size_t before = values.size();
+			query(queries[order[p]], values);
+			result.offsets[order[p] + 1] = values.size() - before;
+		}
+	};
+	auto copyChunk = [&](size_t t) {
+		auto local = localValues[t].begin();
+		for (size_t p = chunkStart(t); p < chunkStart(t + 1); p++) {
+			const size_t count =
+				result.offsets[order[p] + 1] - result.offsets[order[p]];
+			std::copy(
+				local, local + count,
+				std::next(result.values.begin(), result.offsets[order[p]]));
+			local += count;
+		}
+	};
+	auto runParallel = [threads](const auto& func) {
+		std::vector<std::future<void>> futures;
+		for (size_t t = 1; t < threads; t++) {
+			futures.emplace_back(std::async(std::launch::async, func, t));
+		}
+		func(0);
+		for (auto& f : futures) {
+			f.get();
+		}
+	};
+
+	runParallel(runChunk);
+
+	std::partial_sum(
+		result.offsets.begin(), result.offsets.end(), result.offsets.begin());
+	result.values.resize(result.offsets.back());
+
+	runParallel(copyChunk);
+	return result;
+}
+
+#endif	// BATCH_QUERY_HPP
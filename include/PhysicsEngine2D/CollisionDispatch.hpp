@@ -0,0 +1,32 @@
+#ifndef COLLISION_DISPATCH_HPP
+#define COLLISION_DISPATCH_HPP
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+/**
+ * Compile time helpers for the collision dispatch table of Simulator. Type
+ * lists are tuples, the compact id of a shape type is its position in the
+ * list of stored shapes.
+ */
+template <class T1, class T2> struct ShapePair {
+	using First = T1;
+	using Second = T2;
+};
+
+template <class T, class List> struct TypeIndex;
+template <class T, class... Types>
+struct TypeIndex<T, std::tuple<T, Types...>>
+	: std::integral_constant<size_t, 0> {};
+template <class T, class U, class... Types>
+struct TypeIndex<T, std::tuple<U, Types...>>
+	: std::integral_constant<
+		  size_t, 1 + TypeIndex<T, std::tuple<Types...>>::value> {};
+
+template <class T, class List> struct ContainsType;
+template <class T, class... Types>
+struct ContainsType<T, std::tuple<Types...>>
+	: std::disjunction<std::is_same<T, Types>...> {};
+
+#endif	// COLLISION_DISPATCH_HPP
@@ -3,17 +3,77 @@
 
 #include <PhysicsEngine2D/util.hpp>
 #include <memory>
+#include <memory_resource>
 #include <vector>
 
+#include "Range.hpp"
 #include "Shapes.hpp"
 
-std::vector<std::pair<int, int>> getCollisionBruteForce(
-	const std::vector<std::reference_wrapper<BaseShape>>& objects);
+using CollisionPairs = std::pmr::vector<std::pair<int, int>>;
 
-std::vector<std::pair<int, int>> getCollisionBruteForceSAT(
-	const std::vector<std::reference_wrapper<BaseShape>>& objects);
+/**
+ * Broadphase functions return pairs of indices of objects whose bounding
+ * boxes intersect and whose collision filters let them collide, see
+ * BaseShape::canCollide. Result and scratch memory come from memory, eg the
+ * frame arena of Simulator, so the result must not outlive it.
+ */
+CollisionPairs getCollisionBruteForce(
+	const std::vector<std::reference_wrapper<BaseShape>>& objects,
+	std::pmr::memory_resource* memory = std::pmr::get_default_resource());
 
-std::vector<std::pair<int, int>> getCollisionIntervalTree(
-	const std::vector<std::reference_wrapper<BaseShape>>& objects);
+CollisionPairs getCollisionBruteForceSAT(
+	const std::vector<std::reference_wrapper<BaseShape>>& objects,
+	std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+CollisionPairs getCollisionIntervalTree(
+	const std::vector<std::reference_wrapper<BaseShape>>& objects,
+	std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+/**
+ * Broadphase using a batch of range queries over centers of bounding boxes
+ * of objects. Every box is grown by the largest half extents so that centers
+ * of all overlapping boxes fall inside the query.
+ * @tparam Tree spatial index with batch rangeQuery, eg KdTree<int>
+ */
+template <class Tree>
+CollisionPairs getCollisionRangeQuery(
+	const std::vector<std::reference_wrapper<BaseShape>>& objects,
+	std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+	std::vector<Vector2D> centers;
+	std::vector<int> indices(objects.size());
+	centers.reserve(objects.size());
+	dataType halfWidth = 0, halfHeight = 0;
+	for (size_t i = 0; i < objects.size(); i++) {
+		auto& obj = objects[i].get();
+		centers.emplace_back(
+			0.5f * (obj.left + obj.right), 0.5f * (obj.bottom + obj.top));
+		halfWidth = std::max(halfWidth, 0.5f * (obj.right - obj.left));
+		halfHeight = std::max(halfHeight, 0.5f * (obj.top - obj.bottom));
+		indices[i] = i;
+	}
+
+	std::vector<Range2D<dataType>> queries;
+	queries.reserve(objects.size());
+	for (auto& objRef : objects) {
+		auto& obj = objRef.get();
+		queries.emplace_back(
+			obj.left - halfWidth, obj.right + halfWidth, obj.bottom - halfHeight,
+			obj.top + halfHeight);
+	}
+
+	const Tree tree(centers, indices);
+	const auto result = tree.rangeQuery(queries);
+
+	CollisionPairs collisions(memory);
+	for (size_t i = 0; i < objects.size(); i++) {
+		for (auto j = result.begin(i); j != result.end(i); ++j) {
+			if (int(i) < *j && objects[i].get().canCollide(objects[*j]) &&
+				objects[i].get().intersects(objects[*j])) {
+				collisions.emplace_back(i, *j);
+			}
+		}
+	}
+	return collisions;
+}
 
 #endif	// COLLISION_H
\ No newline at end of file
@@ -4,6 +4,7 @@ enum ShapeType {
 	BASESHAPE = 0b1,		   // 1
 	DYNAMICSHAPE = 0b10001,	   // 17
 	LINE = 0b10010,			   // 18
+	CHAIN = 0b10011,		   // 19
 	PARTICLE = 0b100010001,	   // 273
 	RIGIDSHAPE = 0b100010010,  // 274
 	BALL = 0b1000100100001,	   // 4385
@@ -17,6 +18,8 @@ inline const char* getShapeTypeName(const ShapeType& type) {
 			return "DYNAMICSHAPE";
 		case LINE:
 			return "LINE";
+		case CHAIN:
+			return "CHAIN";
 		case PARTICLE:
 			return "PARTICLE";
 		case RIGIDSHAPE:
@@ -0,0 +1,207 @@
+#ifndef CONTACT_HPP
+#define CONTACT_HPP
+
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "Shapes.hpp"
+#include "Vector2D.hpp"
+
+// Overlap allowed to remain, so resting contacts do not jitter
+const dataType CONTACT_SLOP = 0.005f;
+// Contacts approaching slower than this do not bounce, so resting contacts
+// settle
+const dataType RESTITUTION_THRESHOLD = 0.5f;
+
+struct ContactPoint {
+	Vector2D point;
+	// Negative while the shapes overlap
+	dataType separation = 0;
+	// Features that touch, matches points of consecutive updates
+	uint32_t id = 0;
+	// Impulses applied at the point, kept while the point persists
+	dataType normalImpulse = 0, tangentImpulse = 0;
+};
+
+/**
+ * Contact of two convex shapes, normal points from first to second. Axis of
+ * the last separating axis test is cached, so a pair staying apart along it
+ * is rejected with one projection and a touching pair keeps its reference
+ * face.
+ */
+struct ContactManifold {
+	Vector2D normal;
+	std::array<ContactPoint, 2> points;
+	uint8_t pointCount = 0;
+	// Edge axisEdge of first (0) or second (1) shape, -1 if none is cached
+	int8_t axisOwner = -1;
+	uint8_t axisEdge = 0;
+	// Step the manifold was last updated in, unused manifolds are dropped
+	uint64_t lastStep = 0;
+};
+
+/**
+ * Updates manifold of two convex polygons with counter clockwise vertices,
+ * a segment is a polygon of two vertices. Returns false if they are
+ * separated.
+ */
+bool collidePolygons(
+	const Vector2D* first, int firstCount, const Vector2D* second,
+	int secondCount, ContactManifold& manifold);
+
+/**
+ * Updates manifold of a box and a circle, normal points from box to circle.
+ * Returns false if they are separated.
+ */
+bool collideBoxCircle(
+	const Box& box, const Vector2D& center, dataType radius,
+	ContactManifold& manifold);
+
+/**
+ * Updates manifold of two circles, returns false if they are separated
+ */
+bool collideCircles(
+	const Vector2D& firstCenter, dataType firstRadius,
+	const Vector2D& secondCenter, dataType secondRadius,
+	ContactManifold& manifold);
+
+/**
+ * Updates manifold of a circle and a segment, normal points from circle to
+ * segment. Returns false if they are separated.
+ */
+bool collideCircleSegment(
+	const Vector2D& center, dataType radius, const Vector2D& start,
+	const Vector2D& end, ContactManifold& manifold);
+
+/**
+ * Same as collideCircleSegment, with direction and inverse squared length
+ * the line keeps
+ */
+bool collideCircleLine(
+	const Vector2D& center, dataType radius, const Line& line,
+	ContactManifold& manifold);
+
+/**
+ * Circle and line pairs stored as separate arrays, so touching pairs are
+ * found with a few SIMD operations per group of pairs
+ */
+struct CircleLinePairs {
+	CircleLinePairs(size_t count, std::pmr::memory_resource* memory)
+		: centerX(count, memory),
+		  centerY(count, memory),
+		  radiusSq(count, memory),
+		  startX(count, memory),
+		  startY(count, memory),
+		  directionX(count, memory),
+		  directionY(count, memory),
+		  invLenSq(count, memory) {}
+
+	inline void set(
+		size_t i, const Vector2D& center, dataType radius, const Line& line) {
+		centerX[i] = center.x;
+		centerY[i] = center.y;
+		radiusSq[i] = radius * radius;
+		startX[i] = line.start.x;
+		startY[i] = line.start.y;
+		directionX[i] = line.direction.x;
+		directionY[i] = line.direction.y;
+		invLenSq[i] = line.invLenSq;
+	}
+	inline size_t size() const { return centerX.size(); }
+
+	std::pmr::vector<dataType> centerX, centerY, radiusSq;
+	std::pmr::vector<dataType> startX, startY, directionX, directionY;
+	std::pmr::vector<dataType> invLenSq;
+};
+
+/**
+ * Writes indices of pairs whose circle touches its line to touching, in
+ * increasing order, and returns how many there are. Only squared distances
+ * are compared, so no square root is taken.
+ */
+size_t findTouchingPairs(const CircleLinePairs& pairs, uint32_t* touching);
+
+/**
+ * Updates manifold of a circle and segment of a chain, normal points from
+ * circle to chain. A vertex shared by two segments belongs to the segment
+ * starting there, and is left to the previous segment while the circle is
+ * in front of it, so a circle at a joint gets one contact. Returns false if
+ * they are separated or the contact belongs to another segment.
+ */
+bool collideCircleChain(
+	const Vector2D& center, dataType radius, const Chain& chain,
+	uint32_t segment, ContactManifold& manifold);
+
+/**
+ * Updates manifold of a convex polygon and segment of a chain, normal
+ * points from polygon to chain. Points at a vertex shared by two segments
+ * belong to the segment starting there, and are dropped if their normal
+ * pushes the polygon back over the neighbouring segment, so polygons slide
+ * over joints without catching. Returns false if no point is left.
+ */
+bool collidePolygonChain(
+	const Vector2D* polygon, int count, const Chain& chain, uint32_t segment,
+	ContactManifold& manifold);
+
+/**
+ * One side of a contact, lines and chains do not move and particles do not turn
+ */
+struct ContactBody {
+	DynamicShape* shape = nullptr;
+	RigidShape* rigid = nullptr;
+
+	inline dataType invMass() const { return shape ? shape->invMass : 0; }
+	inline dataType invInertia() const {
+		return rigid ? rigid->invInertia : 0;
+	}
+	inline Vector2D arm(const Vector2D& point) const {
+		return shape ? point - shape->pos : Vector2D();
+	}
+	inline Vector2D velocityAt(const Vector2D& point) const {
+		if (!shape) return Vector2D();
+		if (!rigid) return shape->vel;
+		return shape->vel + rigid->angVel * arm(point).rotate(1, 0);
+	}
+	inline void applyImpulse(const Vector2D& impulse, const Vector2D& point) {
+		if (shape) shape->applyImpulse(impulse, point);
+	}
+};
+
+inline ContactBody contactBody(Line&) { return {}; }
+inline ContactBody contactBody(Chain&) { return {}; }
+inline ContactBody contactBody(Particle& p) { return {&p, nullptr}; }
+inline ContactBody contactBody(RigidShape& r) { return {&r, &r}; }
+
+/**
+ * Contact of a manifold prepared for the solver, impulses accumulate in the
+ * points of the manifold
+ */
+struct SolverContact {
+	ContactBody first, second;
+	ContactManifold* manifold;
+	// Per point, inverse of the effective mass along normal and tangent
+	std::array<dataType, 2> normalMass, tangentMass;
+	// Per point, normal speed the contact should separate with
+	std::array<dataType, 2> velocityBias;
+};
+
+/**
+ * Computes masses and restitution target from current velocities
+ */
+void prepareContact(SolverContact& contact, dataType restitutionCoeff);
+
+/**
+ * Applies impulses cached in the manifold, so the solver starts from the
+ * solution of the last substep
+ */
+void warmStartContact(SolverContact& contact);
+
+/**
+ * One sequential impulse iteration, accumulated normal impulses stay
+ * non-negative and friction stays within the friction cone
+ */
+void solveContact(SolverContact& contact, dataType frictionCoeff);
+
+#endif	// CONTACT_HPP
@@ -0,0 +1,73 @@
+#ifndef EMITTER_HPP
+#define EMITTER_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+#include "Range.hpp"
+#include "Vector2D.hpp"
+
+/**
+ * Spawns particles at a fixed rate. Mass, radius, position, velocity and
+ * lifetime of each particle are drawn uniformly from their ranges.
+ */
+class ParticleEmitter {
+	// Fraction of a particle carried over to next step
+	double pending = 0;
+	std::mt19937 gen;
+
+	// Saves and restores pending and gen in checkpoints
+	friend class Simulator;
+
+   public:
+	// Particles per second
+	double rate;
+	Range<dataType> mass, radius;
+	Range2D<dataType> position, velocity;
+	// Seconds, particles never expire if end of lifetime is infinite
+	Range<dataType> lifetime;
+
+	ParticleEmitter(
+		double rate, const Range<dataType>& mass, const Range<dataType>& radius,
+		const Range2D<dataType>& position,
+		const Range2D<dataType>& velocity = {0, 0, 0, 0},
+		const Range<dataType>& lifetime =
+			{std::numeric_limits<dataType>::infinity(),
+			 std::numeric_limits<dataType>::infinity()},
+		uint32_t seed = std::mt19937::default_seed)
+		: gen(seed),
+		  rate(rate),
+		  mass(mass),
+		  radius(radius),
+		  position(position),
+		  velocity(velocity),
+		  lifetime(lifetime) {}
+
+	/**
+	 * Calls spawn(position, velocity, mass, radius, lifetime) for each
+	 * particle emitted in seconds
+	 */
+	template <typename Spawn> void emit(double seconds, Spawn&& spawn) {
+		pending += rate * seconds;
+		const double count = std::floor(pending);
+		pending -= count;
+		auto uniform = [this](const Range<dataType>& range) {
+			return std::uniform_real_distribution<dataType>(
+				range.start, range.end)(gen);
+		};
+		for (double i = 0; i < count; i++) {
+			const Vector2D pos(
+				uniform(position.rangeX), uniform(position.rangeY));
+			const Vector2D vel(
+				uniform(velocity.rangeX), uniform(velocity.rangeY));
+			const dataType m = uniform(mass), r = uniform(radius);
+			spawn(
+				pos, vel, m, r,
+				std::isinf(lifetime.end) ? lifetime.end : uniform(lifetime));
+		}
+	}
+};
+
+#endif	// EMITTER_HPP
@@ -0,0 +1,63 @@
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * Bump pointer memory resource for temporaries that live for one substep.
+ * Deallocation is a no-op, reset() frees everything at once. Unlike
+ * std::pmr::monotonic_buffer_resource, memory is kept across resets, so
+ * after a few frames allocation never reaches the upstream resource.
+ * Not thread safe, use one arena per thread.
+ */
+class FrameArena final : public std::pmr::memory_resource {
+	struct Chunk {
+		std::byte* data;
+		size_t size;
+	};
+
+	std::pmr::memory_resource* upstream;
+	std::vector<Chunk> chunks;
+	// Chunk being bumped and offset of its first free byte
+	size_t current = 0, offset = 0;
+	size_t used = 0, peak = 0;
+
+	void addChunk(size_t size);
+	void releaseChunks();
+
+   protected:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void*, size_t, size_t) override {}
+	bool do_is_equal(
+		const std::pmr::memory_resource& that) const noexcept override {
+		return this == &that;
+	}
+
+   public:
+	/**
+	 * @param initialSize bytes of first chunk, later chunks double in size
+	 * @param upstream resource chunks are allocated from
+	 */
+	explicit FrameArena(
+		size_t initialSize = 1 << 16,
+		std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+	~FrameArena();
+
+	/**
+	 * Invalidates all allocations. If the last frame needed more than one
+	 * chunk, they are merged into one chunk big enough for all of them.
+	 */
+	void reset();
+
+	// Bytes allocated since last reset, including alignment padding
+	inline size_t bytesUsed() const { return used; }
+	// Most bytes used between two resets
+	inline size_t peakBytesUsed() const { return peak; }
+	size_t capacity() const;
+};
+
+#endif	// FRAME_ARENA_HPP
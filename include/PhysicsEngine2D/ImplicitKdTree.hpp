@@ -0,0 +1,236 @@
+#ifndef IMPLICIT_KD_TREE_HPP
+#define IMPLICIT_KD_TREE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+#include "BatchQuery.hpp"
+#include "Range.hpp"
+#include "Vector2D.hpp"
+#include "util.hpp"
+
+/**
+ * KdTree without child links. Internal nodes only keep their split value and
+ * are stored in Eytzinger (BFS) order, children of node k are 2k and 2k + 1.
+ * Points live in fixed size buckets at the leaves, stored as separate x, y
+ * and value arrays so a whole bucket is tested with a few SIMD compares.
+ */
+template <class ValueType> class ImplicitKdTree {
+	static const int BUCKET_SIZE = 16;
+	static const int MAX_DEPTH = 64;
+
+	size_t N;
+	// Number of leaves, always a power of two
+	size_t leafCount;
+	int depth;
+
+	// splits[k] for internal node k in [1, leafCount)
+	std::vector<dataType> splits;
+	// Bucket of leaf l is [l * BUCKET_SIZE, (l + 1) * BUCKET_SIZE)
+	std::vector<dataType> xs, ys;
+	std::vector<ValueType> values;
+
+	inline size_t leafStart(size_t leaf) const {
+		return N * leaf / leafCount;
+	}
+
+	/**
+	 * Builds node k, which covers leaves [leafLow, leafHigh)
+	 */
+	void build(
+		size_t k, size_t leafLow, size_t leafHigh, int level,
+		const std::vector<Vector2D>& points,
+		const std::vector<ValueType>& pointValues, std::vector<size_t>& order) {
+		const size_t i = leafStart(leafLow), j = leafStart(leafHigh);
+		if (k >= leafCount) {
+			const size_t base = (k - leafCount) * BUCKET_SIZE;
+			for (size_t n = i; n < j; n++) {
+				xs[base + n - i] = points[order[n]].x;
+				ys[base + n - i] = points[order[n]].y;
+				values[base + n - i] = pointValues[order[n]];
+			}
+			return;
+		}
+		const size_t leafMid = (leafLow + leafHigh) / 2;
+		const size_t mid = leafStart(leafMid);
+		const int axis = level % VECTOR_SIZE;
+		if (mid < j) {
+			std::nth_element(
+				std::next(order.begin(), i), std::next(order.begin(), mid),
+				std::next(order.begin(), j), [&](size_t a, size_t b) {
+					return points[a][axis] < points[b][axis];
+				});
+			splits[k] = points[order[mid]][axis];
+		}
+		else {
+			splits[k] = std::numeric_limits<dataType>::max();
+		}
+		build(2 * k, leafLow, leafMid, level + 1, points, pointValues, order);
+		build(
+			2 * k + 1, leafMid, leafHigh, level + 1, points, pointValues, order);
+	}
+
+	/**
+	 * Returns bit mask of points in bucket of leaf that are inside range2d
+	 */
+	inline uint32_t getLeafMask(
+		size_t leaf, const Range2D<dataType>& range2d) const {
+		const size_t base = leaf * BUCKET_SIZE;
+		const size_t count = leafStart(leaf + 1) - leafStart(leaf);
+		uint32_t mask = 0;
+#if defined(__AVX__)
+		if constexpr (std::is_same<dataType, float>::value) {
+			const __m256 xLow = _mm256_set1_ps(range2d.rangeX.start),
+						 xHigh = _mm256_set1_ps(range2d.rangeX.end),
+						 yLow = _mm256_set1_ps(range2d.rangeY.start),
+						 yHigh = _mm256_set1_ps(range2d.rangeY.end);
+			for (int g = 0; g < BUCKET_SIZE; g += 8) {
+				const __m256 x = _mm256_loadu_ps(&xs[base + g]),
+							 y = _mm256_loadu_ps(&ys[base + g]);
+				const __m256 inside = _mm256_and_ps(
+					_mm256_and_ps(
+						_mm256_cmp_ps(xLow, x, _CMP_LE_OQ),
+						_mm256_cmp_ps(x, xHigh, _CMP_LE_OQ)),
+					_mm256_and_ps(
+						_mm256_cmp_ps(yLow, y, _CMP_LE_OQ),
+						_mm256_cmp_ps(y, yHigh, _CMP_LE_OQ)));
+				mask |= uint32_t(_mm256_movemask_ps(inside)) << g;
+			}
+		}
+		else
+#elif defined(__SSE__)
+		if constexpr (std::is_same<dataType, float>::value) {
+			const __m128 xLow = _mm_set1_ps(range2d.rangeX.start),
+						 xHigh = _mm_set1_ps(range2d.rangeX.end),
+						 yLow = _mm_set1_ps(range2d.rangeY.start),
+						 yHigh = _mm_set1_ps(range2d.rangeY.end);
+			for (int g = 0; g < BUCKET_SIZE; g += 4) {
+				const __m128 x = _mm_loadu_ps(&xs[base + g]),
+							 y = _mm_loadu_ps(&ys[base + g]);
+				const __m128 inside = _mm_and_ps(
+					_mm_and_ps(_mm_cmple_ps(xLow, x), _mm_cmple_ps(x, xHigh)),
+					_mm_and_ps(_mm_cmple_ps(yLow, y), _mm_cmple_ps(y, yHigh)));
+				mask |= uint32_t(_mm_movemask_ps(inside)) << g;
+			}
+		}
+		else
+#endif
+		{
+			for (int g = 0; g < BUCKET_SIZE; g++) {
+				mask |= uint32_t(
+							range2d.rangeX.contains(xs[base + g]) &
+							range2d.rangeY.contains(ys[base + g]))
+						<< g;
+			}
+		}
+		// Slots after count are padding
+		return mask & ((uint32_t(1) << count) - 1);
+	}
+
+	template <class Callback>
+	void inRange(const Range2D<dataType>& range2d, Callback&& callback) const {
+		if (N == 0) {
+			return;
+		}
+		std::array<std::pair<size_t, int>, MAX_DEPTH + 1> stack;
+		int top = 0;
+		stack[top++] = {1, 0};
+		while (top > 0) {
+			const auto [k, level] = stack[--top];
+			if (k >= leafCount) {
+				const size_t leaf = k - leafCount;
+				uint32_t mask = getLeafMask(leaf, range2d);
+				while (mask) {
+					callback(leaf * BUCKET_SIZE + __builtin_ctz(mask));
+					mask &= mask - 1;
+				}
+				continue;
+			}
+			const auto& range = level == 0 ? range2d.rangeX : range2d.rangeY;
+			const int nextLevel = (level + 1) % VECTOR_SIZE;
+			if (range.end >= splits[k]) {
+				stack[top++] = {2 * k + 1, nextLevel};
+			}
+			if (range.start <= splits[k]) {
+				stack[top++] = {2 * k, nextLevel};
+			}
+		}
+	}
+
+   public:
+	ImplicitKdTree()
+		: ImplicitKdTree(std::vector<Vector2D>(0), std::vector<ValueType>(0)) {}
+	ImplicitKdTree(
+		const std::vector<Vector2D>& points,
+		const std::vector<ValueType>& values)
+		: N(points.size()), leafCount(1), depth(0) {
+		if (points.size() != values.size()) {
+			throw std::invalid_argument(
+				"Size of points and values should be equal");
+		}
+		while (leafCount * BUCKET_SIZE < N) {
+			leafCount *= 2;
+			depth++;
+		}
+		if (depth > MAX_DEPTH) {
+			throw std::invalid_argument("Too many points for ImplicitKdTree");
+		}
+
+		splits.resize(leafCount);
+		xs.resize(leafCount * BUCKET_SIZE);
+		ys.resize(leafCount * BUCKET_SIZE);
+		this->values.resize(leafCount * BUCKET_SIZE);
+
+		std::vector<size_t> order(N);
+		std::iota(order.begin(), order.end(), 0);
+		build(1, 0, leafCount, 0, points, values, order);
+	}
+
+	/**
+	 * Appends values of points inside range2d to insides, which may use any
+	 * allocator, eg std::pmr::vector on a FrameArena
+	 */
+	template <class Allocator>
+	void rangeQuery(
+		const Range2D<dataType>& range2d,
+		std::vector<ValueType, Allocator>& insides) const {
+		inRange(range2d, [&](size_t slot) { insides.push_back(values[slot]); });
+	}
+
+	auto rangeQuery(const Range2D<dataType>& range2d) const {
+		std::vector<ValueType> insides;
+		rangeQuery(range2d, insides);
+		return insides;
+	}
+
+	/**
+	 * Returns approximate number of bytes used by tree
+	 */
+	size_t memoryUsage() const {
+		return sizeof(*this) + splits.capacity() * sizeof(dataType) +
+			   (xs.capacity() + ys.capacity()) * sizeof(dataType) +
+			   values.capacity() * sizeof(ValueType);
+	}
+
+	BatchQueryResult<ValueType> rangeQuery(
+		const std::vector<Range2D<dataType>>& queries) const {
+		return batchRangeQuery<ValueType>(
+			queries, [this](
+						 const Range2D<dataType>& range2d,
+						 std::vector<ValueType>& insides) {
+				rangeQuery(range2d, insides);
+			});
+	}
+};
+
+#endif	// IMPLICIT_KD_TREE_HPP
@@ -1,6 +1,11 @@
+#ifndef INTERVAL_TREE_HPP
+#define INTERVAL_TREE_HPP
+
+#include <array>
 #include <cassert>
 #include <limits>
-#include <list>
+#include <memory_resource>
+#include <stdexcept>
 #include <tuple>
 #include <vector>
 
@@ -49,8 +54,8 @@ template <class KeyType, class ValueType> class AVL {
 		}
 	};
 
-	std::vector<Node> nodes;
-	std::vector<int> freeMemorySlots;
+	std::pmr::vector<Node> nodes;
+	std::pmr::vector<int> freeMemorySlots;
 
 	int newNode(const Range<KeyType>& range, ValueType val) {
 		if (freeMemorySlots.size() == 0) {
@@ -66,14 +71,59 @@ template <class KeyType, class ValueType> class AVL {
 		return newSlot;
 	}
 
-	int newNode(int index) { return index; }
-
 	void deleteNode(int index) {
 		// printLn("deleteNode", debug(index));
 		freeMemorySlots.push_back(index);
 	}
 
 	int root;
+	// AVL height is at most ~1.44 * log2(N), this is enough for any N that
+	// fits in memory
+	static const int MAX_HEIGHT = 64;
+	using Path = std::array<int, MAX_HEIGHT>;
+
+	inline bool isLess(
+		const Range<KeyType>& range, const ValueType& value, int x) const {
+		return comparePair(range, nodes[x].range, value < nodes[x].value);
+	}
+
+	/**
+	 * Updates and rebalances every node of path[0, length) bottom up,
+	 * reattaching rotated subtrees to their parents
+	 */
+	void fixPath(Path& path, int length) {
+		for (int k = length - 1; k >= 0; k--) {
+			int x = path[k];
+			updateBalance(x);
+			if (nodes[x].balance < -1 || nodes[x].balance > 1) {
+				x = rebalance(x);
+			}
+			if (k == 0) {
+				root = x;
+			}
+			else if (nodes[path[k - 1]].left == path[k]) {
+				nodes[path[k - 1]].left = x;
+			}
+			else {
+				nodes[path[k - 1]].right = x;
+			}
+		}
+	}
+
+	int bulkLoad(
+		int i, int j, const std::vector<Range<KeyType>>& ranges,
+		const std::vector<ValueType>& values) {
+		if (i >= j) {
+			return NULL_NODE;
+		}
+		int mid = (i + j) / 2;
+		int x = newNode(ranges[mid], values[mid]);
+		nodes[x].left = bulkLoad(i, mid, ranges, values);
+		nodes[x].right = bulkLoad(mid + 1, j, ranges, values);
+		updateBalance(x);
+		return x;
+	}
+
 	void updateBalance(int x) {
 		nodes[x].balance = 0;
 		if (nodes[x].left != NULL_NODE)
@@ -96,16 +146,6 @@ template <class KeyType, class ValueType> class AVL {
 			nodes[x].maxEnd =
 				std::max(nodes[nodes[x].right].maxEnd, nodes[x].maxEnd);
 	}
-	int insert(int x, const Range<KeyType>& range, const ValueType& value) {
-		if (x == NULL_NODE) return newNode(range, value);
-		if (comparePair(range, nodes[x].range, value < nodes[x].value))
-			nodes[x].left = insert(nodes[x].left, range, value);
-		else
-			nodes[x].right = insert(nodes[x].right, range, value);
-		updateBalance(x);
-		if (nodes[x].balance < -1 || nodes[x].balance > 1) x = rebalance(x);
-		return x;
-	}
 	int search(int x, KeyType start) {
 		if (x == NULL_NODE) return NULL_NODE;
 		if (nodes[x].range.low > start)
@@ -135,43 +175,6 @@ template <class KeyType, class ValueType> class AVL {
 		}
 		return x;
 	}
-	int remove(int x, const Range<KeyType>& range, const ValueType& value) {
-		// printLn(debug(x), debug(range), debug(value));
-		if (x == NULL_NODE) return NULL_NODE;
-		if (comparePair(range, nodes[x].range, value < nodes[x].value))
-			nodes[x].left = remove(nodes[x].left, range, value);
-		else if (comparePair(nodes[x].range, range, nodes[x].value < value))
-			nodes[x].right = remove(nodes[x].right, range, value);
-		else {
-			if (nodes[x].right == NULL_NODE) {
-				int temp = nodes[x].left;
-				deleteNode(x);
-				return temp;
-			}
-			else if (nodes[x].left == NULL_NODE) {
-				int temp = nodes[x].right;
-				deleteNode(x);
-				return temp;
-			}
-			else {
-				int temp = x;
-				x = newNode(minimum(nodes[x].right));
-				nodes[x].right = removeMin(nodes[temp].right);
-				nodes[x].left = nodes[temp].left;
-				deleteNode(temp);
-			}
-		}
-		updateBalance(x);
-		if (nodes[x].balance < -1 || nodes[x].balance > 1) x = rebalance(x);
-		return x;
-	}
-	void inOrder(int x, std::list<ValueType>& list) {
-		if (x == NULL_NODE) return;
-		inOrder(nodes[x].left, list);
-		// print(x->value);
-		list.emplace_back(nodes[x].value);
-		inOrder(nodes[x].right, list);
-	}
 	int rotateLeft(int h) {
 		int x = nodes[h].right;
 		nodes[h].right = nodes[x].left;
@@ -203,53 +206,179 @@ template <class KeyType, class ValueType> class AVL {
 	}
 	bool intersects(int x, KeyType low, KeyType high) {
 		if (high < nodes[x].range.start) return false;
-		if (nodes[x].maxEnd < low) return false;
+		if (nodes[x].range.end < low) return false;
 		return true;
 	}
-	bool searchAll(
-		int x, KeyType low, KeyType high, std::vector<ValueType>& list) {
+	template <typename Callback>
+	bool searchAll(int x, KeyType low, KeyType high, Callback& callback) {
 		bool found1 = false;
 		bool found2 = false;
 		bool found3 = false;
 		if (x == NULL_NODE) return false;
 		if (intersects(x, low, high)) {
-			// printLn(debug(nodes[x].value), debug(list.size()));
-			list.emplace_back(nodes[x].value);
+			callback(nodes[x].value);
 			found1 = true;
 		}
 		if (nodes[x].left != NULL_NODE && nodes[nodes[x].left].maxEnd >= low)
-			found2 = searchAll(nodes[x].left, low, high, list);
+			found2 = searchAll(nodes[x].left, low, high, callback);
 		if (found2 || nodes[x].left == NULL_NODE ||
 			nodes[nodes[x].left].maxEnd < low)
-			found3 = searchAll(nodes[x].right, low, high, list);
+			found3 = searchAll(nodes[x].right, low, high, callback);
 		return found1 || found2 || found3;
 	}
 
    public:
-	AVL() { root = NULL_NODE; }
-	~AVL() {
-		if (nodes.size() != freeMemorySlots.size()) {
-			throw std::runtime_error("Invalid Memory State For AVL Tree");
-		}
+	/**
+	 * @param memory resource nodes are allocated from, eg a FrameArena
+	 */
+	explicit AVL(
+		std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+		: nodes(memory), freeMemorySlots(memory) {
+		root = NULL_NODE;
 	}
-	inline void insert(KeyType low, KeyType high, ValueType value) {
-		// printLn("insert", debug(low), debug(high), debug(value));
-		root = insert(root, {low, high}, value);
+	void insert(KeyType low, KeyType high, ValueType value) {
+		const Range<KeyType> range(low, high);
+		Path path;
+		int length = 0;
+		for (int x = root; x != NULL_NODE;
+			 x = isLess(range, value, x) ? nodes[x].left : nodes[x].right) {
+			path[length++] = x;
+		}
+		const int x = newNode(range, value);
+		if (length == 0) {
+			root = x;
+			return;
+		}
+		if (isLess(range, value, path[length - 1])) {
+			nodes[path[length - 1]].left = x;
+		}
+		else {
+			nodes[path[length - 1]].right = x;
+		}
+		fixPath(path, length);
 	}
 	inline void removeMin() { root = removeMin(root); }
-	inline void remove(KeyType low, KeyType high, ValueType value) {
-		// printLn("remove", debug(low), debug(high), debug(value));
+	void remove(KeyType low, KeyType high, ValueType value) {
+		const Range<KeyType> range(low, high);
+		Path path;
+		int length = 0;
+		int x = root;
+		while (x != NULL_NODE) {
+			if (isLess(range, value, x)) {
+				path[length++] = x;
+				x = nodes[x].left;
+			}
+			else if (comparePair(nodes[x].range, range, nodes[x].value < value)) {
+				path[length++] = x;
+				x = nodes[x].right;
+			}
+			else {
+				break;
+			}
+		}
+		if (x == NULL_NODE) {
+			return;
+		}
+
+		// Node with two children takes payload of its successor, which is
+		// then unlinked instead
+		if (nodes[x].left != NULL_NODE && nodes[x].right != NULL_NODE) {
+			path[length++] = x;
+			int successor = nodes[x].right;
+			while (nodes[successor].left != NULL_NODE) {
+				path[length++] = successor;
+				successor = nodes[successor].left;
+			}
+			nodes[x].range = nodes[successor].range;
+			nodes[x].value = nodes[successor].value;
+			x = successor;
+		}
 
-		root = remove(root, {low, high}, value);
+		const int child =
+			nodes[x].left != NULL_NODE ? nodes[x].left : nodes[x].right;
+		if (length == 0) {
+			root = child;
+		}
+		else if (nodes[path[length - 1]].left == x) {
+			nodes[path[length - 1]].left = child;
+		}
+		else {
+			nodes[path[length - 1]].right = child;
+		}
+		deleteNode(x);
+		fixPath(path, length);
 	}
-	std::list<ValueType> getInOrder() {
-		std::list<ValueType> list;
-		inOrder(root, list);
+
+	/**
+	 * Replaces contents of tree with given intervals in O(N)
+	 * @param ranges intervals sorted in the order used by the tree (by range,
+	 * then by value)
+	 * @param values value of each interval
+	 */
+	void bulkLoad(
+		const std::vector<Range<KeyType>>& ranges,
+		const std::vector<ValueType>& values) {
+		if (ranges.size() != values.size()) {
+			throw std::invalid_argument(
+				"Size of ranges and values should be equal");
+		}
+		clear();
+		nodes.reserve(ranges.size());
+		root = bulkLoad(0, ranges.size(), ranges, values);
+	}
+
+	/**
+	 * Removes every interval, memory is kept for reuse
+	 */
+	void clear() {
+		root = NULL_NODE;
+		freeMemorySlots.resize(nodes.size());
+		for (size_t i = 0; i < nodes.size(); i++) {
+			freeMemorySlots[i] = nodes.size() - 1 - i;
+		}
+	}
+
+	inline bool empty() const { return root == NULL_NODE; }
+
+	/**
+	 * Calls callback with every value, in sorted order of intervals
+	 */
+	template <typename Callback> void inOrder(Callback&& callback) const {
+		Path stack;
+		int length = 0;
+		int x = root;
+		while (x != NULL_NODE || length > 0) {
+			while (x != NULL_NODE) {
+				stack[length++] = x;
+				x = nodes[x].left;
+			}
+			x = stack[--length];
+			callback(nodes[x].value);
+			x = nodes[x].right;
+		}
+	}
+
+	std::vector<ValueType> getInOrder() const {
+		std::vector<ValueType> list;
+		list.reserve(nodes.size() - freeMemorySlots.size());
+		inOrder([&list](const ValueType& value) { list.emplace_back(value); });
 		return list;
 	}
+
+	/**
+	 * Calls callback with value of every interval intersecting [low, high]
+	 */
+	template <typename Callback>
+	inline void searchAll(KeyType low, KeyType high, Callback&& callback) {
+		searchAll(root, low, high, callback);
+	}
+
 	inline std::vector<ValueType> searchAll(KeyType low, KeyType high) {
 		std::vector<ValueType> list;
-		searchAll(root, low, high, list);
+		auto append = [&list](const ValueType& value) {
+			list.emplace_back(value);
+		};
+		searchAll(root, low, high, append);
 		return list;
 	}
 
@@ -275,3 +404,5 @@ template <class KeyType, class ValueType> class AVL {
 
 	void reserve(size_t size) { nodes.reserve(size); }
 };
+
+#endif	// INTERVAL_TREE_HPP
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <vector>
 
+#include "BatchQuery.hpp"
 #include "Range.hpp"
 #include "Vector2D.hpp"
 #include "util.hpp"
@@ -15,10 +16,15 @@ template <class ValueType> class KdTree {
 	struct Node {
 		Vector2D p;
 		ValueType value;
+		double weight;
 		int left, right;
 		Node() {}
-		Node(const Vector2D& p, const ValueType& value)
-			: p(p), value(value), left(NULL_NODE), right(NULL_NODE) {}
+		Node(const Vector2D& p, const ValueType& value, double weight = 1)
+			: p(p),
+			  value(value),
+			  weight(weight),
+			  left(NULL_NODE),
+			  right(NULL_NODE) {}
 
 		friend std::ostream& operator<<(std::ostream& out, const Node& n) {
 			return out << "[ p=" << n.p << ", value=" << n.value
@@ -27,12 +33,21 @@ template <class ValueType> class KdTree {
 		}
 	};
 
+	// Bounding box and aggregate of all points in subtree of a node
+	struct Subtree {
+		Range2D<dataType> bounds;
+		RangeAggregate aggregate;
+		Subtree() : bounds(0, 0, 0, 0) {}
+	};
+
 	std::vector<Node> nodes;
+	std::vector<Subtree> subtrees;
 	int root = NULL_NODE;
 
+	template <class Allocator>
 	void inRange(
 		int x, int depth, const Range2D<dataType>& range2d,
-		std::vector<ValueType>& insides) {
+		std::vector<ValueType, Allocator>& insides) const {
 		if (x == NULL_NODE) {
 			return;
 		}
@@ -74,9 +89,43 @@ template <class ValueType> class KdTree {
 		nodes[mid].right =
 			generateKdTree(mid + 1, j, (depth + 1) % VECTOR_SIZE);
 
+		auto& subtree = subtrees[mid];
+		subtree.bounds = Range2D<dataType>(
+			nodes[mid].p.x, nodes[mid].p.x, nodes[mid].p.y, nodes[mid].p.y);
+		subtree.aggregate = RangeAggregate().add(nodes[mid].p, nodes[mid].weight);
+		for (int child : {nodes[mid].left, nodes[mid].right}) {
+			if (child == NULL_NODE) {
+				continue;
+			}
+			const auto& bounds = subtrees[child].bounds;
+			subtree.bounds = Range2D<dataType>(
+				std::min(subtree.bounds.rangeX.start, bounds.rangeX.start),
+				std::max(subtree.bounds.rangeX.end, bounds.rangeX.end),
+				std::min(subtree.bounds.rangeY.start, bounds.rangeY.start),
+				std::max(subtree.bounds.rangeY.end, bounds.rangeY.end));
+			subtree.aggregate += subtrees[child].aggregate;
+		}
+
 		return mid;
 	}
 
+	void aggregateInRange(
+		int x, const Range2D<dataType>& range2d,
+		RangeAggregate& aggregate) const {
+		if (x == NULL_NODE || !range2d.intersects(subtrees[x].bounds)) {
+			return;
+		}
+		if (range2d.contains(subtrees[x].bounds)) {
+			aggregate += subtrees[x].aggregate;
+			return;
+		}
+		if (range2d.contains(nodes[x].p)) {
+			aggregate.add(nodes[x].p, nodes[x].weight);
+		}
+		aggregateInRange(nodes[x].left, range2d, aggregate);
+		aggregateInRange(nodes[x].right, range2d, aggregate);
+	}
+
 	void printTree(int root, int level) {
 		if (root == NULL_NODE || root >= nodes.size()) {
 			return;
@@ -90,16 +139,29 @@ template <class ValueType> class KdTree {
 
    public:
 	KdTree() : KdTree(std::vector<Vector2D>(0), std::vector<ValueType>(0)) {}
+	/**
+	 * @param points position of each point
+	 * @param values value of each point
+	 * @param weights weight of each point used by aggregateQuery, every
+	 * weight is 1 if empty
+	 */
 	KdTree(
 		const std::vector<Vector2D>& points,
-		const std::vector<ValueType>& values) {
+		const std::vector<ValueType>& values,
+		const std::vector<double>& weights = {}) {
 		if (points.size() != values.size()) {
 			throw std::invalid_argument(
 				"Size of points and values should be equal");
 		}
+		if (!weights.empty() && weights.size() != points.size()) {
+			throw std::invalid_argument(
+				"Size of points and weights should be equal");
+		}
 		for (size_t i = 0; i < points.size(); ++i) {
-			nodes.emplace_back(points[i], values[i]);
+			nodes.emplace_back(
+				points[i], values[i], weights.empty() ? 1.0 : weights[i]);
 		}
+		subtrees.resize(nodes.size());
 
 		// for (size_t i = 0; i < points.size(); i++) {
 		// 	print(__FILE__, __LINE__, debug(i));
@@ -138,10 +200,53 @@ template <class ValueType> class KdTree {
 		// printTree(root, 0);
 	}
 
-	auto rangeQuery(const Range2D<dataType>& range2d) {
-		std::vector<ValueType> insides;
+	/**
+	 * Appends values of points inside range2d to insides, which may use any
+	 * allocator, eg std::pmr::vector on a FrameArena
+	 */
+	template <class Allocator>
+	void rangeQuery(
+		const Range2D<dataType>& range2d,
+		std::vector<ValueType, Allocator>& insides) const {
 		inRange(root, 0, range2d, insides);
+	}
+
+	auto rangeQuery(const Range2D<dataType>& range2d) const {
+		std::vector<ValueType> insides;
+		rangeQuery(range2d, insides);
 		return insides;
 	}
+
+	/**
+	 * Returns count, total weight and centroid of points inside range2d
+	 * without visiting subtrees that are completely inside or outside it
+	 */
+	RangeAggregate aggregateQuery(const Range2D<dataType>& range2d) const {
+		RangeAggregate aggregate;
+		aggregateInRange(root, range2d, aggregate);
+		return aggregate;
+	}
+
+	inline size_t countQuery(const Range2D<dataType>& range2d) const {
+		return aggregateQuery(range2d).count;
+	}
+
+	/**
+	 * Returns approximate number of bytes used by tree
+	 */
+	size_t memoryUsage() const {
+		return sizeof(*this) + nodes.capacity() * sizeof(Node) +
+			   subtrees.capacity() * sizeof(Subtree);
+	}
+
+	BatchQueryResult<ValueType> rangeQuery(
+		const std::vector<Range2D<dataType>>& queries) const {
+		return batchRangeQuery<ValueType>(
+			queries, [this](
+						 const Range2D<dataType>& range2d,
+						 std::vector<ValueType>& insides) {
+				rangeQuery(range2d, insides);
+			});
+	}
 };
 #endif	// KD_TREE_HPP
@@ -0,0 +1,36 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+/**
+ * Read only view of a whole file. Uses mmap where available, otherwise the
+ * file is read into memory.
+ */
+class MappedFile {
+	const char* begin = nullptr;
+	size_t length = 0;
+#if !defined(__unix__) && !defined(__APPLE__)
+	std::vector<char> buffer;
+#endif
+
+	void unmap();
+
+   public:
+	/**
+	 * Throws std::runtime_error if file can not be opened or mapped
+	 */
+	explicit MappedFile(const std::filesystem::path& filePath);
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& that) noexcept;
+	MappedFile& operator=(MappedFile&& that) noexcept;
+	~MappedFile();
+
+	inline const char* data() const { return begin; }
+	inline size_t size() const { return length; }
+};
+
+#endif	// MAPPED_FILE_HPP
@@ -51,4 +51,48 @@ template <class Type> struct Range2D {
 	}
 };
 
+/**
+ * Count, total weight and weighted position sum of a set of points
+ */
+struct RangeAggregate {
+	size_t count = 0;
+	double weight = 0;
+	double weightedX = 0, weightedY = 0;
+
+	inline RangeAggregate& add(const Vector2D& p, double w) {
+		count++;
+		weight += w;
+		weightedX += w * p.x;
+		weightedY += w * p.y;
+		return *this;
+	}
+
+	inline RangeAggregate& operator+=(const RangeAggregate& that) {
+		count += that.count;
+		weight += that.weight;
+		weightedX += that.weightedX;
+		weightedY += that.weightedY;
+		return *this;
+	}
+
+	inline RangeAggregate operator-(const RangeAggregate& that) const {
+		RangeAggregate result;
+		result.count = count - that.count;
+		result.weight = weight - that.weight;
+		result.weightedX = weightedX - that.weightedX;
+		result.weightedY = weightedY - that.weightedY;
+		return result;
+	}
+
+	/**
+	 * Weighted mean position, origin if weight is zero
+	 */
+	inline Vector2D centroid() const {
+		if (weight == 0) {
+			return Vector2D();
+		}
+		return Vector2D(weightedX / weight, weightedY / weight);
+	}
+};
+
 #endif	// RANGE_HPP
@@ -3,11 +3,16 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <future>
 #include <iostream>
 #include <set>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
+#include "BatchQuery.hpp"
 #include "Range.hpp"
 #include "Vector2D.hpp"
 #include "util.hpp"
@@ -18,6 +23,7 @@ template <class ValueType> class RangeTree2D {
 	struct Meta {
 		Vector2D point;
 		ValueType value;
+		double weight;
 	};
 
 	struct YNode {
@@ -27,7 +33,7 @@ template <class ValueType> class RangeTree2D {
 		YNode() : meta(nullptr), left(NULL_NODE), right(NULL_NODE) {}
 		YNode(const Meta* d) : meta(d), left(NULL_NODE), right(NULL_NODE) {}
 
-		inline bool operator<(const YNode& that) {
+		inline bool operator<(const YNode& that) const {
 			return comparePair(
 				this->meta->point.y, that.meta->point.y,
 				comparePair(
@@ -82,22 +88,140 @@ template <class ValueType> class RangeTree2D {
 	std::vector<Meta> data;
 	std::vector<XNode> xNodes;
 	std::vector<std::vector<YNode>> yTrees;
+	// yPrefix[x][k] is aggregate of first k points of yTrees[x], only built
+	// when weights are given
+	std::vector<std::vector<RangeAggregate>> yPrefix;
 	const size_t N;
-	size_t freeNode;
+	bool hasWeights = false;
+
+	void buildPrefix(int x) {
+		auto& prefix = yPrefix[x];
+		prefix.resize(yTrees[x].size() + 1);
+		for (size_t k = 0; k < yTrees[x].size(); k++) {
+			prefix[k + 1] = prefix[k];
+			prefix[k + 1].add(yTrees[x][k].meta->point, yTrees[x][k].meta->weight);
+		}
+	}
 
-	size_t getNextFreeNode() {
-		if (freeNode-- <= 0) {
-			throw std::runtime_error("Invalid Memory State For RangeTree2D");
+	/**
+	 * Maps position pos in y-array of x to position in y-array of a child,
+	 * position is the number of elements before it
+	 */
+	inline int toChild(int x, int pos, bool toLeft) const {
+		const int child = toLeft ? xNodes[x].left : xNodes[x].right;
+		if (pos == int(yTrees[x].size())) {
+			return yTrees[child].size();
+		}
+		const int index = toLeft ? yTrees[x][pos].left : yTrees[x][pos].right;
+		return index == NULL_NODE ? int(yTrees[child].size()) : index;
+	}
+
+	void aggregateInRange(
+		int x, int yStart, int yEnd, const Range2D<dataType>& range2d,
+		RangeAggregate& aggregate) const {
+		if (x == NULL_NODE || yStart >= yEnd) {
+			return;
+		}
+
+		if (xNodes[x].meta != nullptr) {
+			if (range2d.contains(xNodes[x].meta->point)) {
+				aggregate.add(xNodes[x].meta->point, xNodes[x].meta->weight);
+			}
+			return;
+		}
+
+		if (range2d.rangeX.contains(xNodes[x].range)) {
+			if (hasWeights) {
+				aggregate += yPrefix[x][yEnd] - yPrefix[x][yStart];
+			}
+			else {
+				aggregate.count += yEnd - yStart;
+			}
+		}
+		else if (range2d.rangeX.intersects(xNodes[x].range)) {
+			aggregateInRange(
+				xNodes[x].left, toChild(x, yStart, true),
+				toChild(x, yEnd, true), range2d, aggregate);
+			aggregateInRange(
+				xNodes[x].right, toChild(x, yStart, false),
+				toChild(x, yEnd, false), range2d, aggregate);
+		}
+	}
+
+	RangeAggregate aggregate(const Range2D<dataType>& range2d) const {
+		RangeAggregate aggregate;
+		if (N == 0) {
+			return aggregate;
+		}
+		const auto& root = yTrees[1];
+		const int yStart =
+			std::partition_point(
+				root.begin(), root.end(),
+				[&](const YNode& node) {
+					return node.meta->point.y < range2d.rangeY.start;
+				}) -
+			root.begin();
+		const int yEnd = std::partition_point(
+							 root.begin(), root.end(),
+							 [&](const YNode& node) {
+								 return node.meta->point.y <= range2d.rangeY.end;
+							 }) -
+						 root.begin();
+		aggregateInRange(1, yStart, yEnd, range2d, aggregate);
+		return aggregate;
+	}
+
+	static const int PARALLEL_BUILD_CUTOFF = 1 << 12;
+	static const int PARALLEL_MERGE_CUTOFF = 1 << 15;
+
+	/**
+	 * Merges y-arrays of left and right child into y-array of their parent,
+	 * only the part of output in [outStart, outEnd) is written
+	 */
+	void mergeYArrays(
+		std::vector<YNode>& yArray, const std::vector<YNode>& leftYArray,
+		const std::vector<YNode>& rightYArray, int outStart, int outEnd) {
+		const int n = leftYArray.size(), m = rightYArray.size();
+
+		// Find how many elements of left array are in first outStart elements
+		// of the merged output (co-rank). Ties are taken from right array.
+		int lo = std::max(0, outStart - m), hi = std::min(outStart, n);
+		while (lo < hi) {
+			int mid = (lo + hi) / 2;
+			if (leftYArray[mid] < rightYArray[outStart - mid - 1]) {
+				lo = mid + 1;
+			}
+			else {
+				hi = mid;
+			}
+		}
+
+		int i = lo, j = outStart - lo;
+		for (int k = outStart; k < outEnd; k++) {
+			const int leftIndex = i < n ? i : NULL_NODE,
+					  rightIndex = j < m ? j : NULL_NODE;
+			if (i < n && (j >= m || leftYArray[i] < rightYArray[j])) {
+				yArray[k] = leftYArray[i];
+				i++;
+			}
+			else {
+				yArray[k] = rightYArray[j];
+				j++;
+			}
+			yArray[k].left = leftIndex;
+			yArray[k].right = rightIndex;
 		}
-		return freeNode;
 	}
 
 	/**
 	 * Returns index of root node of Range Tree build with xNodes [i,j)
 	 * @param i start index (inclusive)
 	 * @param j end index (exclusive)
+	 * @param nodeEnd internal nodes of this subtree use indices in
+	 * [nodeEnd - (j - i - 1), nodeEnd)
+	 * @param threads number of threads this subtree can use
 	 */
-	int build2DRangeTree(int i, int j) {
+	int build2DRangeTree(int i, int j, int nodeEnd, int threads) {
 		if (i >= j) {
 			return NULL_NODE;
 		}
@@ -108,14 +232,25 @@ template <class ValueType> class RangeTree2D {
 
 		int mid = (i + j) / 2;
 
-		// std::nth_element(
-		// 	std::next(xNodes.begin(), i + N), std::next(xNodes.begin(), mid +
-		// N), 	std::next(xNodes.begin(), j + N));
+		int subRootIndex = nodeEnd - (j - i - 1);
+		if (subRootIndex <= 0) {
+			throw std::runtime_error("Invalid Memory State For RangeTree2D");
+		}
 
-		int right = build2DRangeTree(mid, j);
-		int left = build2DRangeTree(i, mid);
+		int left, right;
+		if (threads > 1 && j - i >= PARALLEL_BUILD_CUTOFF) {
+			auto rightFuture = std::async(
+				std::launch::async, &RangeTree2D::build2DRangeTree, this, mid,
+				j, nodeEnd, threads / 2);
+			left = build2DRangeTree(
+				i, mid, nodeEnd - (j - mid - 1), threads - threads / 2);
+			right = rightFuture.get();
+		}
+		else {
+			right = build2DRangeTree(mid, j, nodeEnd, 1);
+			left = build2DRangeTree(i, mid, nodeEnd - (j - mid - 1), 1);
+		}
 
-		int subRootIndex = getNextFreeNode();
 		auto& subRoot = xNodes[subRootIndex];
 
 		if (left != NULL_NODE) {
@@ -125,49 +260,30 @@ template <class ValueType> class RangeTree2D {
 			subRoot.range.end = xNodes[right].range.end;
 		}
 		{
-			int i = 0, j = 0, k = 0;
 			auto &yArray = yTrees[subRootIndex], &leftYArray = yTrees[left],
 				 &rightYArray = yTrees[right];
-
-			yArray.resize(leftYArray.size() + rightYArray.size());
-
-			while (i < leftYArray.size() && j < rightYArray.size()) {
-				if (leftYArray[i] < rightYArray[j]) {
-					yArray[k] = leftYArray[i];
-					yArray[k].left = i;
-					yArray[k].right = j;
-					i++;
-				}
-				else {
-					yArray[k] = rightYArray[j];
-					yArray[k].left = i;
-					yArray[k].right = j;
-					j++;
-				}
-				k++;
+			const int size = leftYArray.size() + rightYArray.size();
+
+			yArray.resize(size);
+
+			const int parts =
+				size >= PARALLEL_MERGE_CUTOFF ? std::max(1, threads) : 1;
+			std::vector<std::future<void>> futures;
+			for (int p = 1; p < parts; p++) {
+				futures.emplace_back(std::async(
+					std::launch::async, &RangeTree2D::mergeYArrays, this,
+					std::ref(yArray), std::cref(leftYArray),
+					std::cref(rightYArray), int(size * int64_t(p) / parts),
+					int(size * int64_t(p + 1) / parts)));
 			}
-			while (i < leftYArray.size()) {
-				yArray[k] = leftYArray[i];
-				yArray[k].left = i;
-				yArray[k].right = NULL_NODE;
-				i++;
-				k++;
-			}
-			while (j < rightYArray.size()) {
-				yArray[k] = rightYArray[j];
-				yArray[k].left = NULL_NODE;
-				yArray[k].right = j;
-				j++;
-				k++;
+			mergeYArrays(yArray, leftYArray, rightYArray, 0, size / parts);
+			for (auto& f : futures) {
+				f.get();
 			}
 		}
-		// std::merge(
-		// 	xNodes[left].yTree.begin(), xNodes[left].yTree.end(),
-		// 	xNodes[right].yTree.begin(), xNodes[right].yTree.end(),
-		// 	std::back_inserter(subRoot.yTree));
-		// for (int n = i; n < j; n++) {
-		// 	subRoot.yTree.emplace(xNodes[n + N].point, xNodes[n + N].value);
-		// }
+		if (hasWeights) {
+			buildPrefix(subRootIndex);
+		}
 		subRoot.left = left;
 		subRoot.right = right;
 
@@ -230,9 +346,10 @@ template <class ValueType> class RangeTree2D {
 		return x;
 	}
 
+	template <class Allocator>
 	void inRange(
 		int x, int yStart, const Range2D<dataType>& range2d,
-		std::vector<ValueType>& insides) {
+		std::vector<ValueType, Allocator>& insides) const {
 		if (x == NULL_NODE) {
 			return;
 		}
@@ -266,27 +383,40 @@ template <class ValueType> class RangeTree2D {
    public:
 	RangeTree2D()
 		: RangeTree2D(std::vector<Vector2D>(0), std::vector<ValueType>(0)) {}
+	/**
+	 * @param points position of each point
+	 * @param values value of each point
+	 * @param weights weight of each point, aggregateQuery is only available
+	 * when these are given as they cost O(N log N) extra memory
+	 */
 	RangeTree2D(
 		const std::vector<Vector2D>& points,
-		const std::vector<ValueType>& values)
-		: N(points.size()) {
+		const std::vector<ValueType>& values,
+		const std::vector<double>& weights = {})
+		: N(points.size()), hasWeights(!weights.empty()) {
 		if (points.size() != values.size()) {
 			throw std::invalid_argument(
 				"Size of points and values should be equal");
 		}
+		if (hasWeights && weights.size() != points.size()) {
+			throw std::invalid_argument(
+				"Size of points and weights should be equal");
+		}
 		if (N == 0) {
 			return;
 		}
 
-		freeNode = N;
-
 		xNodes.resize(2 * N);
 		yTrees.resize(2 * N);
 		data.resize(N);
+		if (hasWeights) {
+			yPrefix.resize(2 * N);
+		}
 
 		for (size_t i = 0; i < N; i++) {
 			data[i].point = points[i];
 			data[i].value = values[i];
+			data[i].weight = hasWeights ? weights[i] : 1;
 			auto& node = xNodes[N + i];
 			node.meta = &data[i];
 			node.range.start = node.range.end = points[i].x;
@@ -295,31 +425,91 @@ template <class ValueType> class RangeTree2D {
 		std::sort(std::next(xNodes.begin(), N), xNodes.end());
 		for (size_t i = 0; i < N; i++) {
 			yTrees[N + i].emplace_back(xNodes[N + i].meta);
+			if (hasWeights) {
+				buildPrefix(N + i);
+			}
 		}
 
-		build2DRangeTree(0, N);
+		build2DRangeTree(
+			0, N, N, std::max(1u, std::thread::hardware_concurrency()));
 		// printTree(1);
 	}
 
-	auto rangeQuery(const Range2D<dataType>& range2d) {
-		std::vector<ValueType> insides;
-		insides.reserve(N / 4);
+	/**
+	 * Appends values of points inside range2d to insides, which may use any
+	 * allocator, eg std::pmr::vector on a FrameArena
+	 */
+	template <class Allocator>
+	void rangeQuery(
+		const Range2D<dataType>& range2d,
+		std::vector<ValueType, Allocator>& insides) const {
 		if (N == 0) {
-			return insides;
+			return;
 		}
 		Meta fakeMeta;
-		fakeMeta.point = Vector2D(0, range2d.rangeY.start);
+		fakeMeta.point = Vector2D(
+			std::numeric_limits<dataType>::lowest(), range2d.rangeY.start);
 		fakeMeta.value = ValueType();
 		auto yStartIter = std::lower_bound(
 			yTrees[1].begin(), yTrees[1].end(), YNode{&fakeMeta});
 		if (yStartIter == yTrees[1].end()) {
-			return insides;
+			return;
 		}
 
 		inRange(
 			1, std::distance(yTrees[1].begin(), yStartIter), range2d, insides);
+	}
+
+	auto rangeQuery(const Range2D<dataType>& range2d) const {
+		std::vector<ValueType> insides;
+		insides.reserve(N / 4);
+		rangeQuery(range2d, insides);
 		return insides;
 	}
+
+	/**
+	 * Returns count, total weight and centroid of points inside range2d
+	 * without visiting points of nodes completely inside it
+	 * @throws std::logic_error if tree was built without weights
+	 */
+	RangeAggregate aggregateQuery(const Range2D<dataType>& range2d) const {
+		if (!hasWeights && N != 0) {
+			throw std::logic_error(
+				"RangeTree2D needs weights for aggregate queries");
+		}
+		return aggregate(range2d);
+	}
+
+	inline size_t countQuery(const Range2D<dataType>& range2d) const {
+		return aggregate(range2d).count;
+	}
+
+	/**
+	 * Returns approximate number of bytes used by tree
+	 */
+	size_t memoryUsage() const {
+		size_t bytes = sizeof(*this) + data.capacity() * sizeof(Meta) +
+					   xNodes.capacity() * sizeof(XNode) +
+					   yTrees.capacity() * sizeof(std::vector<YNode>) +
+					   yPrefix.capacity() * sizeof(std::vector<RangeAggregate>);
+		for (auto& yTree : yTrees) {
+			bytes += yTree.capacity() * sizeof(YNode);
+		}
+		for (auto& prefix : yPrefix) {
+			bytes += prefix.capacity() * sizeof(RangeAggregate);
+		}
+		return bytes;
+	}
+
+	BatchQueryResult<ValueType> rangeQuery(
+		const std::vector<Range2D<dataType>>& queries) const {
+		return batchRangeQuery<ValueType>(
+			queries, [this](
+						 const Range2D<dataType>& range2d,
+						 std::vector<ValueType>& insides) {
+				rangeQuery(range2d, insides);
+			});
+	}
 };
 
 #endif	// RANGE_TREE_2D_HPP
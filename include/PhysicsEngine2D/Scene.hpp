@@ -0,0 +1,98 @@
+#ifndef SCENE_HPP
+#define SCENE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <ostream>
+#include <random>
+#include <string>
+
+#include "SceneFormat.hpp"
+#include "Simulator.hpp"
+#include "Vector2D.hpp"
+
+/**
+ * Parses a scene in text format, one item per line:
+ *
+ * SIZE width height left top right bottom
+ * TITLE title
+ * LINE x1 y1 x2 y2
+ * CHAIN x1 y1 x2 y2 [x3 y3 ...]
+ * PARTICLE mass radius x y [vx vy]
+ * BALL mass radius x y [vx vy [angle [angularVelocity]]]
+ * BOX mass width height x y [vx vy [angle [angularVelocity]]]
+ * GRAVITY x y
+ * REPEAT count PARTICLE massMin massMax radMin radMax xMin xMax yMin yMax
+ * EMITTER rate massMin massMax radMin radMax xMin xMax yMin yMax
+ *     [vxMin vxMax vyMin vyMax [lifeMin lifeMax]]
+ * END
+ *
+ * Lines starting with # are ignored. Errors are thrown as
+ * std::invalid_argument nested in a std::runtime_error naming the line.
+ *
+ * @param seed seed of random generator used by REPEAT and EMITTER
+ */
+SceneData parseScene(
+	std::istream& in, uint32_t seed = std::random_device()());
+
+/**
+ * Parses a scene in text format held in memory, eg a MappedFile. Large
+ * scenes are split into line aligned chunks that are parsed in parallel,
+ * the result is the same as parsing sequentially.
+ *
+ * @param threads maximum number of threads, 0 for hardware concurrency
+ */
+SceneData parseScene(
+	const char* data, size_t size, uint32_t seed = std::random_device()(),
+	unsigned threads = 0);
+
+/**
+ * Clears sim and adds all items of scene
+ */
+SceneInfo addScene(const SceneView& scene, Simulator& sim);
+
+/**
+ * Clears sim and fills it from a scene in text format, see parseScene
+ */
+SceneInfo loadScene(
+	std::istream& in, Simulator& sim,
+	uint32_t seed = std::random_device()());
+
+/**
+ * Clears sim and fills it from a scene file. Binary files are detected by
+ * their magic and mapped, anything else is parsed as text.
+ */
+SceneInfo loadScene(
+	const std::filesystem::path& filePath, Simulator& sim,
+	uint32_t seed = std::random_device()());
+
+/**
+ * Writes lines, chains, particles, balls, boxes and emitters of sim in the
+ * format read by loadScene, with full precision. Force fields, lifetimes of
+ * particles, collision filters and random state of emitters can not be
+ * written.
+ */
+void writeScene(std::ostream& out, const Simulator& sim);
+
+/**
+ * Writes scene in binary format, see SceneFileHeader
+ */
+void writeBinaryScene(std::ostream& out, const SceneView& scene);
+
+/**
+ * Returns view of a binary scene held in memory, eg a MappedFile, records
+ * are not copied. Throws std::invalid_argument if data is not a valid
+ * binary scene.
+ */
+SceneView readBinaryScene(const char* data, size_t size);
+
+inline bool isBinaryScene(const char* data, size_t size) {
+	return size >= sizeof(SCENE_FILE_MAGIC) &&
+		   std::equal(
+			   SCENE_FILE_MAGIC, SCENE_FILE_MAGIC + sizeof(SCENE_FILE_MAGIC),
+			   data);
+}
+
+#endif	// SCENE_HPP
@@ -0,0 +1,152 @@
+#ifndef SCENE_FORMAT_HPP
+#define SCENE_FORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Vector2D.hpp"
+
+/**
+ * Settings of a scene file that are not part of the simulation
+ */
+struct SceneInfo {
+	std::string title;
+	// Window size in pixels, 0 if scene has no SIZE line
+	unsigned width = 0, height = 0;
+	// World coordinates shown at top left and bottom right of window
+	Vector2D topLeft, bottomRight;
+};
+
+// Records of a scene, stored as is in binary scene files. Doubles keep
+// shapes written by writeScene exact.
+
+struct LineRecord {
+	double x1, y1, x2, y2;
+};
+
+struct ParticleRecord {
+	double mass, radius, x, y, vx, vy;
+};
+
+struct BallRecord {
+	double mass, radius, x, y, vx, vy, angle, angularVelocity;
+};
+
+struct BoxRecord {
+	double mass, width, height, x, y, vx, vy, angle, angularVelocity;
+};
+
+// Vertices firstVertex to firstVertex + vertexCount - 1 of the vertex
+// section
+struct ChainRecord {
+	uint64_t firstVertex, vertexCount;
+};
+
+struct VertexRecord {
+	double x, y;
+};
+
+struct GravityRecord {
+	double x, y;
+};
+
+struct EmitterRecord {
+	double rate, massMin, massMax, radMin, radMax;
+	double xMin, xMax, yMin, yMax;
+	double vxMin, vxMax, vyMin, vyMax;
+	double lifeMin, lifeMax;
+	uint32_t seed;
+	uint32_t reserved;
+};
+
+/**
+ * Binary scene file layout, all integers and floats are native endian:
+ * header, then each section at an 8 byte aligned offset from file start.
+ * Sections are flat arrays of records, title is a char array.
+ */
+static const char SCENE_FILE_MAGIC[4] = {'P', 'E', '2', 'S'};
+static const uint32_t SCENE_FILE_VERSION = 2;
+static const uint32_t SCENE_FILE_BYTE_ORDER = 0x01020304;
+
+struct SceneFileSection {
+	uint64_t offset;
+	uint64_t count;
+};
+
+struct SceneFileHeader {
+	char magic[4];
+	uint32_t version;
+	// SCENE_FILE_BYTE_ORDER as written by the machine that wrote the file
+	uint32_t byteOrder;
+	uint32_t width, height;
+	float left, top, right, bottom;
+	uint32_t reserved;
+	SceneFileSection title, lines, particles, balls, boxes, gravities,
+		emitters;
+	// Since version 2
+	SceneFileSection chains, vertices;
+};
+
+// Version 1 headers end before the chain sections
+static const size_t SCENE_FILE_V1_HEADER_SIZE =
+	offsetof(SceneFileHeader, chains);
+
+static_assert(std::is_trivially_copyable<SceneFileHeader>::value, "");
+static_assert(sizeof(LineRecord) == 32, "");
+static_assert(sizeof(ParticleRecord) == 48, "");
+static_assert(sizeof(EmitterRecord) == 128, "");
+
+template <class T> struct RecordSpan {
+	const T* records = nullptr;
+	size_t count = 0;
+
+	RecordSpan() = default;
+	RecordSpan(const T* records, size_t count)
+		: records(records), count(count) {}
+	RecordSpan(const std::vector<T>& vec)
+		: records(vec.data()), count(vec.size()) {}
+
+	inline const T* begin() const { return records; }
+	inline const T* end() const { return records + count; }
+	inline size_t size() const { return count; }
+};
+
+/**
+ * Scene without storage of its own, eg records of a mapped binary file
+ */
+struct SceneView {
+	SceneInfo info;
+	RecordSpan<LineRecord> lines;
+	RecordSpan<ParticleRecord> particles;
+	RecordSpan<BallRecord> balls;
+	RecordSpan<BoxRecord> boxes;
+	RecordSpan<GravityRecord> gravities;
+	RecordSpan<EmitterRecord> emitters;
+	RecordSpan<ChainRecord> chains;
+	RecordSpan<VertexRecord> vertices;
+};
+
+/**
+ * Scene parsed from text, REPEAT items are already expanded
+ */
+struct SceneData {
+	SceneInfo info;
+	std::vector<LineRecord> lines;
+	std::vector<ParticleRecord> particles;
+	std::vector<BallRecord> balls;
+	std::vector<BoxRecord> boxes;
+	std::vector<GravityRecord> gravities;
+	std::vector<EmitterRecord> emitters;
+	std::vector<ChainRecord> chains;
+	std::vector<VertexRecord> vertices;
+
+	inline SceneView view() const {
+		return {info,	   lines,	 particles, balls, boxes,
+				gravities, emitters, chains,	vertices};
+	}
+};
+
+#endif	// SCENE_FORMAT_HPP
@@ -3,11 +3,21 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
 
 #include "Constants.hpp"
 #include "Vector2D.hpp"
 
 std::ostream& operator<<(std::ostream& out, const ShapeType& type);
+
+// Collision categories set by default, shapes may use any other bits
+const uint32_t DYNAMIC_CATEGORY = 1;
+const uint32_t STATIC_CATEGORY = 1 << 1;
+const uint32_t ALL_CATEGORIES = 0xFFFFFFFF;
+
 class BaseShape {
    protected:
 	inline void setBounds(
@@ -22,6 +32,14 @@ class BaseShape {
 	BaseShape() : top(0), left(0), right(0), bottom(0) {}
 	virtual ~BaseShape() {}
 	virtual ShapeType getClass() { return BASESHAPE; }
+	/**
+	 * Whether broadphase may pair the shapes, each one's category has to be
+	 * in the other's mask
+	 */
+	inline bool canCollide(const BaseShape& anotherShape) const {
+		return (category & anotherShape.mask) &&
+			   (anotherShape.category & mask);
+	}
 	bool intersects(const BaseShape& anotherShape) const {
 		if (this->right < anotherShape.left) return false;
 		if (this->left > anotherShape.right) return false;
@@ -34,6 +52,10 @@ class BaseShape {
 				   << "[]";
 	}
 	dataType top, left, right, bottom;
+	// Collision filter, see canCollide. Static shapes do not collide with
+	// each other by default.
+	uint32_t category = DYNAMIC_CATEGORY;
+	uint32_t mask = ALL_CATEGORIES;
 };
 
 class DynamicShape : public BaseShape {
@@ -153,22 +175,16 @@ class Ball final : public RigidShape {
 // Box class
 class Box final : public RigidShape {
 	void updateAABB(double delTime) {
-		const auto sine = std::sin(angle), cosine = std::cos(angle);
-		auto first = Vector2D(w, h).rotate(sine, cosine),
-			 second = Vector2D(-w, h).rotate(sine, cosine);
-		corner[0] = pos + 0.5 * first;
-		corner[1] = pos + 0.5 * second;
-		corner[2] = pos - 0.5 * first;
-		corner[3] = pos - 0.5 * second;
+		updateCorners();
 		auto X =
 			std::minmax({corner[0].x, corner[1].x, corner[2].x, corner[3].x});
 		auto Y =
 			std::minmax({corner[0].y, corner[1].y, corner[2].y, corner[3].y});
 		setBounds(
-			pos.x + X.first + std::min(0.0, delTime * vel.x),
-			pos.y + Y.first + std::min(0.0, delTime * vel.y),
-			pos.x + X.second + std::max(0.0, delTime * vel.x),
-			pos.y + Y.second + std::max(0.0, delTime * vel.y));
+			X.first + std::min(0.0, delTime * vel.x),
+			Y.first + std::min(0.0, delTime * vel.y),
+			X.second + std::max(0.0, delTime * vel.x),
+			Y.second + std::max(0.0, delTime * vel.y));
 	}
 
    public:
@@ -184,6 +200,18 @@ class Box final : public RigidShape {
 	}
 	~Box() {}
 	ShapeType getClass() { return BOX; }
+	/**
+	 * Corners are counter clockwise, call after moving the box by hand
+	 */
+	void updateCorners() {
+		const auto sine = std::sin(angle), cosine = std::cos(angle);
+		auto first = Vector2D(w, h).rotate(sine, cosine),
+			 second = Vector2D(-w, h).rotate(sine, cosine);
+		corner[0] = pos + 0.5 * first;
+		corner[1] = pos + 0.5 * second;
+		corner[2] = pos - 0.5 * first;
+		corner[3] = pos - 0.5 * second;
+	}
 	double w;
 	double h;
 	std::array<Vector2D, 4> corner;
@@ -195,7 +223,11 @@ class Line final : public BaseShape {
 		: start(a),
 		  end(b),
 		  normal((b - a).rotate(1, 0).unit()),
-		  length((b - a).len()) {
+		  length((b - a).len()),
+		  direction(b - a),
+		  invLenSq(1 / (b - a).lenSq()) {
+		category = STATIC_CATEGORY;
+		mask = ALL_CATEGORIES & ~STATIC_CATEGORY;
 		const double padding = std::max(0.05, 0.01 * (a - b).len());
 		setBounds(
 			std::min(start.x, end.x) - padding,
@@ -217,6 +249,153 @@ class Line final : public BaseShape {
 	Vector2D end;
 	Vector2D normal;
 	dataType length;
+	// end - start and inverse of its squared length, lines never change so
+	// contact tests use these as is
+	Vector2D direction;
+	dataType invLenSq;
+};
+
+/**
+ * Static polyline, eg outline of an exported object. Vertices are stored
+ * once and the chain is a single broadphase entry, segments touching a
+ * bounding box are found with a bounding volume hierarchy over runs of
+ * consecutive segments. A chain whose last vertex equals its first is a
+ * loop.
+ */
+class Chain final : public BaseShape {
+	struct Node {
+		dataType left, bottom, right, top;
+		// Segments first to last - 1
+		uint32_t first, last;
+		// Node visited next if this one is skipped, nodes are in depth
+		// first order
+		uint32_t skip;
+	};
+
+	std::vector<Vector2D> vertices;
+	std::vector<Node> nodes;
+	bool loop;
+
+	void build(uint32_t first, uint32_t last) {
+		const uint32_t index = nodes.size();
+		nodes.push_back({0, 0, 0, 0, first, last, 0});
+		if (last - first > LEAF_SEGMENTS) {
+			const uint32_t middle = first + (last - first) / 2;
+			build(first, middle);
+			const uint32_t right = nodes.size();
+			build(middle, last);
+			const auto &a = nodes[index + 1], &b = nodes[right];
+			auto& node = nodes[index];
+			node.left = std::min(a.left, b.left);
+			node.bottom = std::min(a.bottom, b.bottom);
+			node.right = std::max(a.right, b.right);
+			node.top = std::max(a.top, b.top);
+		}
+		else {
+			auto& node = nodes[index];
+			node.left = node.bottom = std::numeric_limits<dataType>::max();
+			node.right = node.top = std::numeric_limits<dataType>::lowest();
+			for (uint32_t i = first; i < last; i++) {
+				const auto &a = vertices[i], &b = vertices[i + 1];
+				// Same padding as Line
+				const dataType padding = std::max(0.05, 0.01 * (a - b).len());
+				node.left = std::min({node.left, a.x - padding, b.x - padding});
+				node.bottom =
+					std::min({node.bottom, a.y - padding, b.y - padding});
+				node.right =
+					std::max({node.right, a.x + padding, b.x + padding});
+				node.top = std::max({node.top, a.y + padding, b.y + padding});
+			}
+		}
+		nodes[index].skip = nodes.size();
+	}
+
+   public:
+	// Segments of a leaf of the hierarchy
+	static const uint32_t LEAF_SEGMENTS = 4;
+
+	/**
+	 * Repeated consecutive vertices are dropped, so no segment has zero
+	 * length. Throws std::invalid_argument if less than two vertices are
+	 * left.
+	 */
+	explicit Chain(std::vector<Vector2D> chainVertices)
+		: vertices(std::move(chainVertices)) {
+		vertices.erase(
+			std::unique(vertices.begin(), vertices.end()), vertices.end());
+		if (vertices.size() < 2) {
+			throw std::invalid_argument("Chain needs at least two vertices");
+		}
+		loop = vertices.size() > 2 && vertices.front() == vertices.back();
+		category = STATIC_CATEGORY;
+		mask = ALL_CATEGORIES & ~STATIC_CATEGORY;
+		nodes.reserve(2 * (segmentCount() / LEAF_SEGMENTS + 1));
+		build(0, segmentCount());
+		setBounds(nodes[0].left, nodes[0].bottom, nodes[0].right, nodes[0].top);
+	}
+	~Chain() {}
+	ShapeType getClass() { return CHAIN; }
+
+	inline const std::vector<Vector2D>& getVertices() const { return vertices; }
+	inline uint32_t segmentCount() const { return vertices.size() - 1; }
+	inline const Vector2D& segmentStart(uint32_t segment) const {
+		return vertices[segment];
+	}
+	inline const Vector2D& segmentEnd(uint32_t segment) const {
+		return vertices[segment + 1];
+	}
+	inline bool isLoop() const { return loop; }
+
+	/**
+	 * Segment sharing the start of segment, or segmentCount() if the chain
+	 * starts there
+	 */
+	inline uint32_t previous(uint32_t segment) const {
+		if (segment > 0) return segment - 1;
+		return loop ? segmentCount() - 1 : segmentCount();
+	}
+	/**
+	 * Segment sharing the end of segment, or segmentCount() if the chain
+	 * ends there
+	 */
+	inline uint32_t next(uint32_t segment) const {
+		if (segment + 1 < segmentCount()) return segment + 1;
+		return loop ? 0 : segmentCount();
+	}
+
+	/**
+	 * Calls f with index of every segment of each leaf whose padded
+	 * bounding box intersects bounds of shape. Segments of a leaf are not
+	 * tested one by one, so f also gets up to LEAF_SEGMENTS - 1 candidates
+	 * that do not come near shape.
+	 */
+	template <class Function>
+	void querySegments(const BaseShape& shape, Function&& f) const {
+		for (uint32_t i = 0; i < nodes.size();) {
+			const auto& node = nodes[i];
+			if (shape.right < node.left || shape.left > node.right ||
+				shape.top < node.bottom || shape.bottom > node.top) {
+				i = node.skip;
+			}
+			else if (node.last - node.first > LEAF_SEGMENTS) {
+				i++;
+			}
+			else {
+				for (uint32_t segment = node.first; segment < node.last;
+					 segment++) {
+					f(segment);
+				}
+				i = node.skip;
+			}
+		}
+	}
+
+	friend std::ostream& operator<<(std::ostream& out, Chain const& c) {
+		return out << "Chain"
+				   << "["
+				   << "vertices:" << c.vertices.size() << ", "
+				   << static_cast<const BaseShape&>(c) << "]";
+	}
 };
 
 inline bool isTypeof(ShapeType a, ShapeType b) {
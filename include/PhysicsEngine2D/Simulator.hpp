@@ -1,18 +1,35 @@
 #ifndef SIMULATOR_H
 #define SIMULATOR_H
 
+#include <array>
+#include <cstdint>
 #include <functional>
+#include <istream>
 #include <memory>
+#include <memory_resource>
+#include <ostream>
+#include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "CollisionDispatch.hpp"
+#include "Contact.hpp"
+#include "Emitter.hpp"
+#include "FrameArena.hpp"
 #include "IntervalTree.hpp"
 #include "KdTree.hpp"
 #include "Shapes.hpp"
+#include "SlotMap.hpp"
+#include "Stats.hpp"
 
 class ForceField {
 	std::function<Vector2D(const DynamicShape&, const ForceField&)> func;
+	// Set for fields made by uniform, only these can be saved by Simulator
+	bool uniform = false;
+	Vector2D acceleration;
 
    public:
 	Vector2D pos;
@@ -21,6 +38,21 @@ class ForceField {
 			f,
 		const Vector2D& p = Vector2D())
 		: func(f), pos(p) {}
+
+	/**
+	 * Field with the same acceleration everywhere, eg gravity
+	 */
+	static ForceField makeUniform(const Vector2D& acceleration) {
+		ForceField field([acceleration](const DynamicShape& a,
+										const ForceField&) {
+			return acceleration * a.mass;
+		});
+		field.uniform = true;
+		field.acceleration = acceleration;
+		return field;
+	}
+	bool isUniform() const { return uniform; }
+	const Vector2D& getAcceleration() const { return acceleration; }
 	Vector2D getForce(const DynamicShape& obj) const {
 		return func(obj, *this);
 	}
@@ -28,35 +60,282 @@ class ForceField {
 };
 
 class Simulator {
-	bool areReferencesValid = false;
 	unsigned subStep;
 
 	std::vector<ForceField> forceFields;
 
-	std::vector<Line> lines;
-	std::vector<Particle> particles;
-	std::vector<Ball> balls;
-	std::vector<Box> boxes;
+	// Shapes stored by the simulator, position in this list is the compact
+	// id of a shape type
+	using StoredShapes = std::tuple<Line, Particle, Ball, Box, Chain>;
+	static constexpr size_t SHAPE_ID_COUNT = std::tuple_size<StoredShapes>::value;
+	template <class T> static constexpr uint8_t shapeIdOf() {
+		return TypeIndex<T, StoredShapes>::value;
+	}
+
+	// Pairs with a manageCollision specialization, the collision dispatch
+	// table is generated from these. Pairs of other types are ignored.
+	using CollisionHandlers = std::tuple<
+		ShapePair<Particle, Line>, ShapePair<Particle, Particle>,
+		ShapePair<Ball, Line>, ShapePair<Ball, Particle>,
+		ShapePair<Ball, Ball>, ShapePair<Box, Line>, ShapePair<Box, Particle>,
+		ShapePair<Box, Ball>, ShapePair<Box, Box>, ShapePair<Particle, Chain>,
+		ShapePair<Ball, Chain>, ShapePair<Box, Chain>>;
 
-	std::vector<std::reference_wrapper<DynamicShape>> dynamicShapes;
+	template <class T> struct ShapeStore {
+		static constexpr uint8_t shapeId = shapeIdOf<T>();
+		SlotMap<T> shapes;
+		// Position in baseShapes of shape in each slot
+		std::vector<uint32_t> basePositions;
+	};
+	struct BaseShapeOwner {
+		std::vector<uint32_t>* basePositions;
+		uint32_t slot;
+		uint8_t shapeId;
+	};
+
+	ShapeStore<Line> lines;
+	ShapeStore<Particle> particles;
+	ShapeStore<Ball> balls;
+	ShapeStore<Box> boxes;
+	ShapeStore<Chain> chains;
+
+	// Unordered, kept up to date on every add and remove
 	std::vector<std::reference_wrapper<BaseShape>> baseShapes;
+	std::vector<BaseShapeOwner> baseShapeOwners;
+
+	// Simulated seconds since construction or clear
+	double time = 0;
 
-	void invalidateReferences();
-	void updateReferences();
+	SlotMap<ParticleEmitter> emitters;
+	struct Expiry {
+		Handle<Particle> particle;
+		double time;
+	};
+	// Particles with finite lifetime, capacity is reused so steady churn
+	// does not allocate
+	std::vector<Expiry> expiries;
+
+	// Identifies shapes by type, slot and generation of their handles, and
+	// the segment of a chain
+	struct ManifoldKey {
+		uint64_t first, second;
+		uint32_t segment;
+		inline bool operator==(const ManifoldKey& that) const {
+			return first == that.first && second == that.second &&
+				   segment == that.segment;
+		}
+	};
+	struct ManifoldKeyHash {
+		inline size_t operator()(const ManifoldKey& key) const {
+			return (key.first * 0x9E3779B97F4A7C15ull ^ key.second) +
+				   key.segment * 0xC2B2AE3D27D4EB4Full;
+		}
+	};
+	// Contact manifolds of shape pairs, persist across substeps and are
+	// dropped after a step that did not use them. Nodes come from a pool, so
+	// steady churn of contacts does not allocate.
+	std::pmr::unsynchronized_pool_resource manifoldPool;
+	std::pmr::unordered_map<ManifoldKey, ContactManifold, ManifoldKeyHash>
+		manifolds{&manifoldPool};
+	uint64_t contactStep = 0;
+	// Contacts of the current substep, capacity is reused
+	std::vector<SolverContact> solverContacts;
+
+	SimulationStats stats;
+	TraceRecorder* traceRecorder = nullptr;
+
+	// Scratch memory of a substep, reset at start of every substep
+	FrameArena frameArena;
 
 	template <typename T1, typename T2>
 	bool manageCollision(T1& t1, T2& t2, float);
+	template <typename T1, typename T2>
+	void addContact(T1& first, T2& second, ContactManifold& manifold);
+	void solveContacts();
+
+	template <class T> uint64_t manifoldKeyOf(const T& shape) const {
+		const auto& store = getStore<T>();
+		const uint32_t slot =
+			store.shapes.slotOf(&shape - store.shapes.data().data());
+		return uint64_t(store.shapeId) << 56 |
+			   uint64_t(store.shapes.getSlots()[slot].generation & 0xFFFFFF)
+				   << 32 |
+			   slot;
+	}
+	template <class T1, class T2>
+	ContactManifold& getManifold(
+		const T1& first, const T2& second, uint32_t segment = 0) {
+		auto& manifold =
+			manifolds[{manifoldKeyOf(first), manifoldKeyOf(second), segment}];
+		manifold.lastStep = contactStep;
+		return manifold;
+	}
+
+	using CollisionPair = std::pair<int, int>;
+	using CollisionBatch = void (Simulator::*)(
+		const CollisionPair*, const CollisionPair*, float);
+
+	/**
+	 * Handles a batch of candidate pairs of objects of types T1 and T2, or
+	 * of T2 and T1 if Swapped
+	 */
+	template <typename T1, typename T2, bool Swapped>
+	void manageCollisions(
+		const CollisionPair* begin, const CollisionPair* end, float seconds) {
+		if constexpr (
+			std::is_same<T2, Line>::value &&
+			(std::is_same<T1, Particle>::value ||
+			 std::is_same<T1, Ball>::value)) {
+			manageCircleLineCollisions<T1, Swapped>(begin, end, seconds);
+		}
+		else {
+			size_t contacts = 0;
+			for (auto pair = begin; pair != end; ++pair) {
+				auto& first = baseShapes[pair->first].get();
+				auto& second = baseShapes[pair->second].get();
+				if constexpr (Swapped) {
+					contacts += manageCollision(
+						static_cast<T1&>(second), static_cast<T2&>(first),
+						seconds);
+				}
+				else {
+					contacts += manageCollision(
+						static_cast<T1&>(first), static_cast<T2&>(second),
+						seconds);
+				}
+			}
+			stats.contacts += contacts;
+		}
+	}
+
+	/**
+	 * Handles a batch of pairs of circles of type T and lines, or of lines
+	 * and circles if Swapped. Pairs that touch are found for the whole batch
+	 * first, so pairs that do not never look up their manifold. The default
+	 * build has no -mavx, so it tests 4 pairs at a time with SSE; the 8 wide
+	 * AVX path only runs in builds that enable AVX themselves.
+	 */
+	template <typename T, bool Swapped>
+	void manageCircleLineCollisions(
+		const CollisionPair* begin, const CollisionPair* end, float seconds);
+
+	/**
+	 * Batch handler of pairs with compact ids Key / SHAPE_ID_COUNT and
+	 * Key % SHAPE_ID_COUNT, nullptr if no handler covers them
+	 */
+	template <size_t Key> static constexpr CollisionBatch collisionBatchOf() {
+		using T1 = std::tuple_element_t<Key / SHAPE_ID_COUNT, StoredShapes>;
+		using T2 = std::tuple_element_t<Key % SHAPE_ID_COUNT, StoredShapes>;
+		if constexpr (ContainsType<
+						  ShapePair<T1, T2>, CollisionHandlers>::value) {
+			return &Simulator::manageCollisions<T1, T2, false>;
+		}
+		else if constexpr (ContainsType<
+							   ShapePair<T2, T1>, CollisionHandlers>::value) {
+			return &Simulator::manageCollisions<T2, T1, true>;
+		}
+		else {
+			return nullptr;
+		}
+	}
+	template <size_t... Keys>
+	static constexpr std::array<CollisionBatch, sizeof...(Keys)>
+	makeCollisionBatches(std::index_sequence<Keys...>) {
+		return {collisionBatchOf<Keys>()...};
+	}
+
+	/**
+	 * Groups candidate pairs by the types of their objects and runs each
+	 * group through its entry of the dispatch table
+	 */
+	void manageCollisions(
+		const std::pmr::vector<CollisionPair>& pairs, float seconds);
+
+	template <class T> auto& getStore() {
+		static_assert(
+			std::is_same<T, Line>::value || std::is_same<T, Particle>::value ||
+				std::is_same<T, Ball>::value || std::is_same<T, Box>::value ||
+				std::is_same<T, Chain>::value,
+			"Simulator has no storage for this shape");
+		if constexpr (std::is_same<T, Line>::value) return lines;
+		else if constexpr (std::is_same<T, Particle>::value) return particles;
+		else if constexpr (std::is_same<T, Ball>::value) return balls;
+		else if constexpr (std::is_same<T, Box>::value) return boxes;
+		else return chains;
+	}
+	template <class T> const auto& getStore() const {
+		return const_cast<Simulator*>(this)->getStore<T>();
+	}
 
 	template <typename T, typename... Args>
-	void addObject(std::vector<T>& vec, Args&&... args) {
-		vec.emplace_back(args...);
-		invalidateReferences();
+	Handle<T> addObject(ShapeStore<T>& store, Args&&... args) {
+		const T* oldData = store.shapes.data().data();
+		const auto handle = store.shapes.emplace(std::forward<Args>(args)...);
+		if (store.basePositions.size() <= handle.index) {
+			store.basePositions.resize(handle.index + 1);
+		}
+		store.basePositions[handle.index] = baseShapes.size();
+		baseShapes.emplace_back(*store.shapes.get(handle));
+		baseShapeOwners.push_back(
+			{&store.basePositions, handle.index, store.shapeId});
+		if (store.shapes.data().data() != oldData) {
+			// Amortized O(1) as capacity grows geometrically
+			rebaseShapes(store);
+		}
+		return handle;
+	}
+
+	/**
+	 * Points entries of baseShapes to new storage of store
+	 */
+	template <typename T> void rebaseShapes(ShapeStore<T>& store) {
+		auto& shapes = store.shapes.data();
+		for (size_t i = 0; i < shapes.size(); i++) {
+			baseShapes[store.basePositions[store.shapes.slotOf(i)]] = shapes[i];
+		}
+	}
+
+	template <typename T>
+	bool removeObject(ShapeStore<T>& store, const Handle<T>& handle) {
+		if (!store.shapes.contains(handle)) {
+			return false;
+		}
+		removeBaseShape(store.basePositions[handle.index]);
+		const uint32_t index = store.shapes.indexOf(handle);
+		store.shapes.erase(handle);
+		// Last shape was moved into index
+		if (index < store.shapes.size()) {
+			baseShapes[store.basePositions[store.shapes.slotOf(index)]] =
+				store.shapes.data()[index];
+		}
+		return true;
+	}
+
+	template <typename T> void reserveObjects(ShapeStore<T>& store, size_t n) {
+		const T* oldData = store.shapes.data().data();
+		store.shapes.reserve(store.shapes.size() + n);
+		if (store.shapes.data().data() != oldData) {
+			rebaseShapes(store);
+		}
+	}
+
+	void removeBaseShape(uint32_t position);
+
+	void emitParticles(float seconds);
+	void removeExpiredParticles();
+
+	template <typename Function> void forEachDynamicShape(Function&& f) {
+		for (auto& ball : balls.shapes) f(ball);
+		for (auto& particle : particles.shapes) f(particle);
+		for (auto& box : boxes.shapes) f(box);
 	}
 
    public:
 	float restitutionCoeff;
 	float frictionCoeff;
 	float nBodyGravity;
+	// Velocity iterations of the contact solver per substep
+	unsigned solverIterations = 8;
 	Simulator(
 		unsigned subStep = 10, float restitutionCoeff = 1.0f,
 		float frictionCoeff = 0.5f, float nBodyGravity = 0.0f);
@@ -65,23 +344,101 @@ class Simulator {
 	const std::vector<Particle>& getParticles() const;
 	const std::vector<Ball>& getBalls() const;
 	const std::vector<Box>& getBoxes() const;
+	const std::vector<Chain>& getChains() const;
 	const std::vector<std::reference_wrapper<BaseShape>>& getBaseShapes() const;
+	const SimulationStats& getStats() const;
+	/**
+	 * Records phases of each substep to recorder, nullptr stops recording.
+	 * Recorder is not owned and must outlive its use by the simulator
+	 */
+	void setTraceRecorder(TraceRecorder* recorder);
+
+	template <typename... Args> inline Handle<Line> addLine(Args&&... args) {
+		return addObject(lines, std::forward<Args>(args)...);
+	}
+	template <typename... Args>
+	inline Handle<Particle> addParticle(Args&&... args) {
+		return addObject(particles, std::forward<Args>(args)...);
+	}
+	template <typename... Args> inline Handle<Ball> addBall(Args&&... args) {
+		return addObject(balls, std::forward<Args>(args)...);
+	}
+	template <typename... Args> inline Handle<Box> addBox(Args&&... args) {
+		return addObject(boxes, std::forward<Args>(args)...);
+	}
+	/**
+	 * Adds a static polyline through vertices, see Chain. Prefer it to many
+	 * lines for connected geometry.
+	 */
+	inline Handle<Chain> addChain(std::vector<Vector2D> vertices) {
+		return addObject(chains, std::move(vertices));
+	}
 
-	template <typename... Args> inline void addLine(Args&&... args) {
-		addObject(lines, args...);
+	/**
+	 * Removes shape of handle in O(1), returns false if handle is stale.
+	 * References to shapes of the same type are invalidated.
+	 */
+	template <typename T> inline bool remove(const Handle<T>& handle) {
+		return removeObject(getStore<T>(), handle);
 	}
-	template <typename... Args> inline void addParticle(Args&&... args) {
-		addObject(particles, args...);
+
+	/**
+	 * Returns shape of handle, or nullptr if handle is stale
+	 */
+	template <typename T> inline T* get(const Handle<T>& handle) {
+		return getStore<T>().shapes.get(handle);
 	}
-	template <typename... Args> inline void addBall(Args&&... args) {
-		addObject(balls, args...);
+	template <typename T> inline const T* get(const Handle<T>& handle) const {
+		return getStore<T>().shapes.get(handle);
 	}
-	template <typename... Args> inline void addBox(Args&&... args) {
-		addObject(balls, args...);
+
+	/**
+	 * Returns handle of index-th shape of vector returned by getLines,
+	 * getParticles, getBalls, getBoxes or getChains
+	 */
+	template <typename T> inline Handle<T> getHandle(size_t index) const {
+		return getStore<T>().shapes.handleOf(index);
 	}
 
+	/**
+	 * Reserves room for this many more shapes of each type, so bulk adds do
+	 * not reallocate
+	 */
+	void reserve(size_t lines, size_t particles, size_t balls, size_t boxes);
+
 	void addForceField(const ForceField forceField);
 
+	Handle<ParticleEmitter> addEmitter(const ParticleEmitter& emitter);
+	bool removeEmitter(const Handle<ParticleEmitter>& handle);
+	ParticleEmitter* getEmitter(const Handle<ParticleEmitter>& handle);
+	const std::vector<ParticleEmitter>& getEmitters() const;
+
+	/**
+	 * Removes particle at end of the first simulate call that reaches
+	 * seconds from now. Expired particles are removed together, and their
+	 * slots are reused by later particles.
+	 */
+	void setLifetime(const Handle<Particle>& particle, double seconds);
+
+	double getTime() const;
+
+	/**
+	 * Writes complete state in binary: shapes with their handles and
+	 * collision filters, force fields, emitters with their random state,
+	 * lifetimes, coefficients, subStep and time. Stats and trace recorder
+	 * are not saved. Throws std::invalid_argument if a force field is not
+	 * uniform, as functions can not be saved.
+	 */
+	void save(std::ostream& out) const;
+
+	/**
+	 * Replaces state with one written by save, handles of the saved
+	 * simulator are valid and simulation continues exactly. Throws
+	 * std::invalid_argument and leaves state unchanged if in is not a
+	 * valid checkpoint.
+	 */
+	void load(std::istream& in);
+
 	void simulate(float delta);
 
 	void clear();
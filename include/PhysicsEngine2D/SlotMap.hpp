@@ -0,0 +1,184 @@
+#ifndef SLOT_MAP_HPP
+#define SLOT_MAP_HPP
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+/**
+ * Generation checked reference to a value in a SlotMap. Stays valid while the
+ * value exists, even when other values are added or removed.
+ */
+template <class T> struct Handle {
+	static const uint32_t NULL_INDEX = std::numeric_limits<uint32_t>::max();
+	uint32_t index = NULL_INDEX;
+	uint32_t generation = 0;
+
+	inline bool operator==(const Handle& that) const {
+		return index == that.index && generation == that.generation;
+	}
+	inline bool operator!=(const Handle& that) const { return !(*this == that); }
+};
+
+/**
+ * Values are stored densely in a vector, slots map stable handles to
+ * positions in it. Add and remove are O(1) amortized, remove moves the last
+ * value into the hole, so pointers to values are invalidated by both.
+ */
+template <class T> class SlotMap {
+	static const uint32_t NULL_INDEX = Handle<T>::NULL_INDEX;
+
+   public:
+	struct Slot {
+		// Position in values, or next free slot if slot is free
+		uint32_t index;
+		// Odd while the slot holds a value
+		uint32_t generation;
+	};
+
+   private:
+	std::vector<T> values;
+	std::vector<uint32_t> valueSlots;
+	std::vector<Slot> slots;
+	uint32_t freeHead = NULL_INDEX;
+
+   public:
+	template <typename... Args> Handle<T> emplace(Args&&... args) {
+		values.emplace_back(std::forward<Args>(args)...);
+		uint32_t slot = freeHead;
+		if (slot == NULL_INDEX) {
+			slot = slots.size();
+			slots.push_back({0, 0});
+		}
+		else {
+			freeHead = slots[slot].index;
+		}
+		slots[slot].index = values.size() - 1;
+		slots[slot].generation++;
+		valueSlots.push_back(slot);
+		return {slot, slots[slot].generation};
+	}
+
+	inline bool contains(const Handle<T>& handle) const {
+		return handle.index < slots.size() &&
+			   slots[handle.index].generation == handle.generation &&
+			   (handle.generation & 1);
+	}
+
+	/**
+	 * Returns false if handle is stale
+	 */
+	bool erase(const Handle<T>& handle) {
+		if (!contains(handle)) {
+			return false;
+		}
+		const uint32_t index = slots[handle.index].index;
+		if (index + 1 != values.size()) {
+			values[index] = std::move(values.back());
+			valueSlots[index] = valueSlots.back();
+			slots[valueSlots[index]].index = index;
+		}
+		values.pop_back();
+		valueSlots.pop_back();
+		slots[handle.index].generation++;
+		slots[handle.index].index = freeHead;
+		freeHead = handle.index;
+		return true;
+	}
+
+	inline T* get(const Handle<T>& handle) {
+		return contains(handle) ? &values[slots[handle.index].index] : nullptr;
+	}
+	inline const T* get(const Handle<T>& handle) const {
+		return contains(handle) ? &values[slots[handle.index].index] : nullptr;
+	}
+
+	/**
+	 * Position of value of handle in data(), handle must be valid
+	 */
+	inline uint32_t indexOf(const Handle<T>& handle) const {
+		return slots[handle.index].index;
+	}
+	inline uint32_t slotOf(size_t index) const { return valueSlots[index]; }
+	inline Handle<T> handleOf(size_t index) const {
+		return {valueSlots[index], slots[valueSlots[index]].generation};
+	}
+
+	/**
+	 * Removes all values, all handles become stale
+	 */
+	void clear() {
+		for (auto slot : valueSlots) {
+			slots[slot].generation++;
+			slots[slot].index = freeHead;
+			freeHead = slot;
+		}
+		values.clear();
+		valueSlots.clear();
+	}
+
+	// Raw state, eg for checkpoints, restore takes the same state back
+
+	inline const std::vector<uint32_t>& getValueSlots() const {
+		return valueSlots;
+	}
+	inline const std::vector<Slot>& getSlots() const { return slots; }
+	inline uint32_t getFreeHead() const { return freeHead; }
+
+	/**
+	 * Returns false if state is inconsistent
+	 */
+	static bool isValidState(
+		size_t valueCount, const std::vector<uint32_t>& valueSlots,
+		const std::vector<Slot>& slots, uint32_t freeHead) {
+		if (valueSlots.size() != valueCount) {
+			return false;
+		}
+		for (size_t i = 0; i < valueSlots.size(); i++) {
+			if (valueSlots[i] >= slots.size() ||
+				slots[valueSlots[i]].index != i ||
+				!(slots[valueSlots[i]].generation & 1)) {
+				return false;
+			}
+		}
+		// Free list must visit each free slot once
+		size_t freeCount = 0;
+		for (uint32_t slot = freeHead; slot != NULL_INDEX;
+			 slot = slots[slot].index) {
+			if (slot >= slots.size() || (slots[slot].generation & 1) ||
+				++freeCount > slots.size() - valueCount) {
+				return false;
+			}
+		}
+		return freeCount == slots.size() - valueCount;
+	}
+
+	/**
+	 * Replaces state, which must be valid, see isValidState
+	 */
+	void restore(
+		std::vector<T>&& values, std::vector<uint32_t>&& valueSlots,
+		std::vector<Slot>&& slots, uint32_t freeHead) {
+		this->values = std::move(values);
+		this->valueSlots = std::move(valueSlots);
+		this->slots = std::move(slots);
+		this->freeHead = freeHead;
+	}
+
+	inline void reserve(size_t size) {
+		values.reserve(size);
+		valueSlots.reserve(size);
+	}
+
+	inline const std::vector<T>& data() const { return values; }
+	inline std::vector<T>& data() { return values; }
+	inline size_t size() const { return values.size(); }
+	inline bool empty() const { return values.empty(); }
+	inline auto begin() { return values.begin(); }
+	inline auto end() { return values.end(); }
+	inline auto begin() const { return values.begin(); }
+	inline auto end() const { return values.end(); }
+};
+
+#endif	// SLOT_MAP_HPP
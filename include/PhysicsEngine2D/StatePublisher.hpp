@@ -0,0 +1,179 @@
+#ifndef STATE_PUBLISHER_HPP
+#define STATE_PUBLISHER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "SlotMap.hpp"
+
+class Simulator;
+
+/**
+ * Shared memory layout, native endian: header, then a ring of frames. Each
+ * frame is a frame header followed by arrays of capacity values each, in
+ * order pos x, pos y, vel x, vel y as floats and ids as uint64. Bodies are
+ * the particles, then balls, then boxes of the simulator. Id of a body is
+ * generation << 32 | index of its handle.
+ */
+static const char SHARED_STATE_MAGIC[4] = {'P', 'E', '2', 'M'};
+static const uint32_t SHARED_STATE_VERSION = 1;
+
+static_assert(
+	std::atomic<uint64_t>::is_always_lock_free,
+	"Shared state needs address free atomics");
+
+struct SharedStateHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t frameCount;
+	// Bodies per frame
+	uint32_t capacity;
+	// Distance between frames
+	uint64_t frameBytes;
+	// Frames published so far, latest is (published - 1) % frameCount
+	std::atomic<uint64_t> published;
+};
+
+/**
+ * Sequence is odd while the frame is written, readers check it did not
+ * change while they read the frame
+ */
+struct alignas(64) SharedFrameHeader {
+	std::atomic<uint64_t> sequence;
+	uint64_t step;
+	double time;
+	uint32_t particles, balls, boxes;
+	uint32_t reserved;
+};
+
+enum SharedStateArray {
+	SHARED_POS_X,
+	SHARED_POS_Y,
+	SHARED_VEL_X,
+	SHARED_VEL_Y,
+	SHARED_IDS,
+	SHARED_STATE_ARRAY_COUNT
+};
+
+/**
+ * Frame in shared memory, valid while the reader that handed it out checks
+ * it was not overwritten
+ */
+struct SharedStateView {
+	uint64_t step;
+	double time;
+	uint32_t particles, balls, boxes;
+	const float *posX, *posY, *velX, *velY;
+	const uint64_t* ids;
+
+	inline size_t size() const { return particles + balls + boxes; }
+};
+
+template <class T> inline uint64_t sharedStateId(const Handle<T>& handle) {
+	return uint64_t(handle.generation) << 32 | handle.index;
+}
+template <class T> inline Handle<T> sharedStateHandle(uint64_t id) {
+	return {uint32_t(id), uint32_t(id >> 32)};
+}
+
+struct StatePublisherOptions {
+	// Frames in the ring, a reader has this many publishes to read a frame
+	unsigned frames = 4;
+	// Bodies per frame
+	size_t capacity = 1 << 16;
+};
+
+/**
+ * Publishes state of a simulation to a POSIX shared memory object, which
+ * other processes map with SharedStateReader. Publishing never waits for
+ * readers, it writes the oldest frame of the ring under a seqlock.
+ */
+class StatePublisher {
+	std::string name;
+	char* address = nullptr;
+	size_t length = 0;
+	SharedStateHeader* header = nullptr;
+	uint64_t steps = 0;
+
+   public:
+	/**
+	 * Name is a shared memory object name like "/physics". An existing
+	 * object of that name is replaced. Throws std::runtime_error if it can
+	 * not be created.
+	 */
+	StatePublisher(
+		const std::string& name, const StatePublisherOptions& options = {});
+	StatePublisher(const StatePublisher&) = delete;
+	StatePublisher& operator=(const StatePublisher&) = delete;
+	/**
+	 * Unlinks the object, readers that mapped it keep their mapping
+	 */
+	~StatePublisher();
+
+	/**
+	 * Call after every step. Returns false and publishes nothing if sim has
+	 * more bodies than capacity.
+	 */
+	bool publish(const Simulator& sim);
+
+	inline uint64_t getPublishedFrames() const {
+		return header->published.load(std::memory_order_relaxed);
+	}
+};
+
+/**
+ * Read only mapping of state published by a StatePublisher
+ */
+class SharedStateReader {
+	char* address = nullptr;
+	size_t length = 0;
+	const SharedStateHeader* header = nullptr;
+
+	const SharedFrameHeader* frameAt(uint64_t index) const;
+	SharedStateView viewOf(const SharedFrameHeader* frame) const;
+
+   public:
+	/**
+	 * Throws std::runtime_error if object can not be mapped and
+	 * std::invalid_argument if it is not published state
+	 */
+	explicit SharedStateReader(const std::string& name);
+	SharedStateReader(const SharedStateReader&) = delete;
+	SharedStateReader& operator=(const SharedStateReader&) = delete;
+	~SharedStateReader();
+
+	inline uint64_t getPublishedFrames() const {
+		return header->published.load(std::memory_order_acquire);
+	}
+	inline uint32_t getCapacity() const { return header->capacity; }
+
+	/**
+	 * Calls consume with a view of the latest frame, without copying it.
+	 * Consume runs again on a newer frame if the frame was overwritten
+	 * meanwhile, so it must not keep the view or act on it before this
+	 * returns. Returns false if nothing was published yet.
+	 */
+	template <typename F> bool readLatest(F&& consume) const {
+		while (true) {
+			const uint64_t published = getPublishedFrames();
+			if (published == 0) {
+				return false;
+			}
+			const auto frame = frameAt(published - 1);
+			const uint64_t sequence =
+				frame->sequence.load(std::memory_order_acquire);
+			if (sequence & 1) {
+				continue;
+			}
+			consume(viewOf(frame));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (frame->sequence.load(std::memory_order_relaxed) == sequence) {
+				return true;
+			}
+		}
+	}
+};
+
+#endif	// STATE_PUBLISHER_HPP
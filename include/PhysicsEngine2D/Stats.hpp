@@ -0,0 +1,124 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include "TraceRecorder.hpp"
+
+enum SimulationPhase {
+	INTEGRATION = 0,
+	FORCE_FIELDS,
+	N_BODY,
+	BROADPHASE,
+	NARROWPHASE,
+	SOLVER,
+	EMITTERS,
+	PHASE_COUNT
+};
+
+inline const char* getPhaseName(const SimulationPhase& phase) {
+	switch (phase) {
+		case INTEGRATION:
+			return "Integration";
+		case FORCE_FIELDS:
+			return "Force Fields";
+		case N_BODY:
+			return "N Body";
+		case BROADPHASE:
+			return "Broadphase";
+		case NARROWPHASE:
+			return "Narrowphase";
+		case SOLVER:
+			return "Solver";
+		case EMITTERS:
+			return "Emitters";
+		case PHASE_COUNT:
+			break;
+	}
+	return "";
+}
+
+using PhaseTimes = std::array<double, PHASE_COUNT>;
+
+/**
+ * Timings and counters of the last Simulator::simulate call. Timings are
+ * only recorded when built with PHYSICS_ENGINE_STATS, counters are always
+ * kept as they are nearly free.
+ */
+struct SimulationStats {
+	// Wall time in seconds of each phase, per substep
+	std::vector<PhaseTimes> subStepSeconds;
+	// Wall time in seconds of each phase, summed over substeps
+	PhaseTimes totalSeconds{};
+
+	size_t candidatePairs = 0;
+	size_t contacts = 0;
+	size_t impulses = 0;
+	// Most frame arena bytes used by a substep
+	size_t frameBytes = 0;
+	// Particles added by emitters and removed at end of lifetime
+	size_t spawned = 0;
+	size_t expired = 0;
+
+	void reset(unsigned subSteps) {
+		subStepSeconds.assign(subSteps, PhaseTimes{});
+		totalSeconds.fill(0);
+		candidatePairs = contacts = impulses = frameBytes = 0;
+		spawned = expired = 0;
+	}
+
+	inline double totalTime() const {
+		double total = 0;
+		for (auto seconds : totalSeconds) total += seconds;
+		return total;
+	}
+};
+
+/**
+ * Adds time between construction and destruction to a phase of a substep,
+ * and records it as begin and end events if a trace recorder is given
+ */
+class ScopedPhaseTimer {
+	using Clock = std::chrono::steady_clock;
+	SimulationStats& stats;
+	TraceRecorder* trace;
+	unsigned subStep;
+	SimulationPhase phase;
+	Clock::time_point start;
+
+   public:
+	ScopedPhaseTimer(
+		SimulationStats& stats, TraceRecorder* trace, unsigned subStep,
+		SimulationPhase phase)
+		: stats(stats),
+		  trace(trace),
+		  subStep(subStep),
+		  phase(phase),
+		  start(Clock::now()) {
+		if (trace) trace->record(getPhaseName(phase), 'B', start);
+	}
+	~ScopedPhaseTimer() {
+		const auto end = Clock::now();
+		if (trace) trace->record(getPhaseName(phase), 'E', end);
+		const double seconds =
+			std::chrono::duration<double>(end - start).count();
+		// Phases outside the substep loop of a simulation without substeps
+		// only count in the totals
+		if (subStep < stats.subStepSeconds.size()) {
+			stats.subStepSeconds[subStep][phase] += seconds;
+		}
+		stats.totalSeconds[phase] += seconds;
+	}
+};
+
+#ifdef PHYSICS_ENGINE_STATS
+#define PHASE_TIMER(stats, trace, subStep, phase) \
+	ScopedPhaseTimer phaseTimer##phase(stats, trace, subStep, phase)
+#else
+#define PHASE_TIMER(stats, trace, subStep, phase)
+#endif
+
+#endif	// STATS_HPP
@@ -0,0 +1,110 @@
+#ifndef TRACE_RECORDER_HPP
+#define TRACE_RECORDER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+struct TraceEvent {
+	// Must point to a string that outlives the recorder, eg a literal
+	const char* name;
+	int64_t nanoseconds;
+	// 'B' for begin, 'E' for end
+	char phase;
+};
+
+/**
+ * Fixed size ring of events written by a single thread. Writer never blocks,
+ * oldest events are overwritten once full.
+ */
+class TraceBuffer {
+	std::vector<TraceEvent> events;
+	const uint64_t mask;
+	std::atomic<uint64_t> written{0};
+
+   public:
+	const std::thread::id owner;
+	const int threadIndex;
+
+	TraceBuffer(size_t capacityPowerOf2, int threadIndex)
+		: events(capacityPowerOf2),
+		  mask(capacityPowerOf2 - 1),
+		  owner(std::this_thread::get_id()),
+		  threadIndex(threadIndex) {}
+
+	inline void push(const TraceEvent& event) {
+		const uint64_t n = written.load(std::memory_order_relaxed);
+		events[n & mask] = event;
+		written.store(n + 1, std::memory_order_release);
+	}
+
+	/**
+	 * Calls callback with events still in the ring, oldest first
+	 */
+	template <typename Callback> void forEach(Callback&& callback) const {
+		const uint64_t n = written.load(std::memory_order_acquire);
+		const uint64_t first = n > events.size() ? n - events.size() : 0;
+		for (uint64_t i = first; i < n; i++) {
+			callback(events[i & mask]);
+		}
+	}
+
+	inline void clear() { written.store(0, std::memory_order_release); }
+};
+
+/**
+ * Records begin and end events per thread and writes them in the Chrome
+ * trace_event JSON format, which chrome://tracing and Perfetto can open.
+ * Recording is lock free except the first event of each thread. Flush with
+ * writeChromeTrace while no thread is recording.
+ */
+class TraceRecorder {
+   public:
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * @param eventsPerThread size of ring of each thread, rounded up to a
+	 * power of two
+	 */
+	explicit TraceRecorder(size_t eventsPerThread = 1 << 16);
+
+	void record(const char* name, char phase, Clock::time_point time);
+	inline void begin(const char* name) { record(name, 'B', Clock::now()); }
+	inline void end(const char* name) { record(name, 'E', Clock::now()); }
+
+	void writeChromeTrace(std::ostream& out) const;
+	void clear();
+
+   private:
+	TraceBuffer& getThreadBuffer();
+
+	const uint64_t id;
+	const size_t capacity;
+	const Clock::time_point startTime;
+	mutable std::mutex mutex;
+	std::vector<std::unique_ptr<TraceBuffer>> buffers;
+};
+
+/**
+ * Records a begin event on construction and an end event on destruction
+ */
+class ScopedTrace {
+	TraceRecorder* recorder;
+	const char* name;
+
+   public:
+	ScopedTrace(TraceRecorder* recorder, const char* name)
+		: recorder(recorder), name(name) {
+		if (recorder) recorder->begin(name);
+	}
+	~ScopedTrace() {
+		if (recorder) recorder->end(name);
+	}
+};
+
+#endif	// TRACE_RECORDER_HPP
@@ -0,0 +1,176 @@
+#ifndef TRAJECTORY_HPP
+#define TRAJECTORY_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "MappedFile.hpp"
+
+class Simulator;
+
+enum TrajectoryField {
+	POS_X,
+	POS_Y,
+	VEL_X,
+	VEL_Y,
+	ANGLE,
+	SIZE_X,
+	SIZE_Y,
+	TRAJECTORY_FIELD_COUNT
+};
+
+/**
+ * State of all dynamic shapes after a step. Bodies are the particles, then
+ * balls, then boxes of the simulator, in the order of getParticles,
+ * getBalls and getBoxes. Size is radius for particles and balls, width and
+ * height for boxes.
+ */
+struct TrajectoryFrame {
+	uint64_t step = 0;
+	double time = 0;
+	uint32_t particles = 0, balls = 0, boxes = 0;
+	std::array<std::vector<float>, TRAJECTORY_FIELD_COUNT> fields;
+
+	/**
+	 * Copies state of sim, capacity of fields is reused
+	 */
+	void capture(const Simulator& sim, uint64_t step);
+
+	inline size_t size() const { return fields[POS_X].size(); }
+};
+
+/**
+ * Resolution of stored values, values are rounded to multiples of these
+ */
+struct TrajectoryQuanta {
+	double position = 1e-4;
+	double velocity = 1e-3;
+	double angle = 1e-4;
+
+	double of(TrajectoryField field) const;
+};
+
+/**
+ * Encodes frames as quantized values delta coded against the previous
+ * frame, stored field by field as zigzag varints. Frames with other body
+ * counts than the previous frame are encoded on their own.
+ */
+class TrajectoryEncoder {
+	TrajectoryQuanta quanta;
+	std::array<std::vector<int64_t>, TRAJECTORY_FIELD_COUNT> previous;
+	uint32_t particles = 0, balls = 0, boxes = 0;
+	bool hasPrevious = false;
+
+   public:
+	explicit TrajectoryEncoder(const TrajectoryQuanta& quanta = {})
+		: quanta(quanta) {}
+
+	/**
+	 * Appends encoded frame to out
+	 */
+	void encode(const TrajectoryFrame& frame, std::vector<uint8_t>& out);
+
+	/**
+	 * Encodes next frame on its own, eg at start of a chunk
+	 */
+	inline void reset() { hasPrevious = false; }
+};
+
+class TrajectoryDecoder {
+	TrajectoryQuanta quanta;
+	std::array<std::vector<int64_t>, TRAJECTORY_FIELD_COUNT> previous;
+
+   public:
+	explicit TrajectoryDecoder(const TrajectoryQuanta& quanta = {})
+		: quanta(quanta) {}
+
+	/**
+	 * Decodes frame starting at begin, returns end of the frame. Throws
+	 * std::invalid_argument if data is truncated or corrupt.
+	 */
+	const uint8_t* decode(
+		const uint8_t* begin, const uint8_t* end, TrajectoryFrame& frame);
+};
+
+/**
+ * Trajectory file layout, native endian: header, then chunks of frames,
+ * each starting with a frame encoded on its own so chunks can be decoded
+ * independently, then an index of the chunks and a footer.
+ */
+static const char TRAJECTORY_FILE_MAGIC[4] = {'P', 'E', '2', 'T'};
+static const char TRAJECTORY_CHUNK_MAGIC[4] = {'P', 'E', '2', 'C'};
+static const char TRAJECTORY_INDEX_MAGIC[4] = {'P', 'E', '2', 'I'};
+static const uint32_t TRAJECTORY_FILE_VERSION = 1;
+static const uint32_t TRAJECTORY_FILE_BYTE_ORDER = 0x01020304;
+
+struct TrajectoryFileHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t byteOrder;
+	// Steps between recorded frames
+	uint32_t stride;
+	double positionQuantum, velocityQuantum, angleQuantum;
+};
+
+struct TrajectoryChunkHeader {
+	char magic[4];
+	uint32_t frameCount;
+	// Bytes of encoded frames following the header
+	uint64_t bytes;
+	uint64_t firstStep;
+};
+
+struct TrajectoryIndexEntry {
+	// Offset of chunk header from file start
+	uint64_t offset;
+	uint64_t firstStep;
+	uint32_t frameCount;
+	uint32_t reserved;
+};
+
+struct TrajectoryFileFooter {
+	uint64_t indexOffset;
+	uint64_t chunkCount;
+	uint64_t frameCount;
+	char magic[4];
+	uint32_t reserved;
+};
+
+/**
+ * Random access to frames of a mapped trajectory file. Files without an
+ * index, eg of an interrupted run, are indexed by scanning their chunks.
+ */
+class TrajectoryReader {
+	MappedFile file;
+	TrajectoryFileHeader header;
+	std::vector<TrajectoryIndexEntry> index;
+	// Prefix sums of frame counts of chunks
+	std::vector<size_t> chunkStarts;
+	TrajectoryDecoder decoder;
+	// Position of decoder, lets sequential reads continue a chunk
+	size_t nextFrame = 0;
+	const uint8_t* nextData = nullptr;
+
+	void scanChunks();
+
+   public:
+	/**
+	 * Throws std::runtime_error if file can not be mapped and
+	 * std::invalid_argument if it is not a trajectory file
+	 */
+	explicit TrajectoryReader(const std::filesystem::path& filePath);
+
+	inline size_t getFrameCount() const { return chunkStarts.back(); }
+	inline unsigned getStride() const { return header.stride; }
+	TrajectoryQuanta getQuanta() const;
+
+	/**
+	 * Decodes index-th frame, reading frames in order decodes each once
+	 */
+	void readFrame(size_t index, TrajectoryFrame& frame);
+};
+
+#endif	// TRAJECTORY_HPP
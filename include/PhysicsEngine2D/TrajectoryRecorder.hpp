@@ -0,0 +1,73 @@
+#ifndef TRAJECTORY_RECORDER_HPP
+#define TRAJECTORY_RECORDER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include "Trajectory.hpp"
+
+struct TrajectoryOptions {
+	// Steps between recorded frames
+	unsigned stride = 1;
+	unsigned framesPerChunk = 64;
+	TrajectoryQuanta quanta;
+};
+
+/**
+ * Records frames of a simulation to a trajectory file. Frames are captured
+ * into a double buffer and encoded and written by a background thread, so
+ * recording never waits for the file. A frame captured while the writer
+ * still has one pending is dropped.
+ */
+class TrajectoryRecorder {
+	TrajectoryOptions options;
+	std::ofstream file;
+
+	// Owned by caller of record
+	TrajectoryFrame captured;
+	uint64_t steps = 0;
+
+	std::mutex mutex;
+	std::condition_variable frameReady;
+	TrajectoryFrame pending;
+	bool hasPending = false;
+	bool closing = false;
+	std::exception_ptr writeError;
+
+	std::atomic<size_t> recordedFrames{0}, droppedFrames{0};
+	std::thread writer;
+
+	void writeFrames();
+
+   public:
+	/**
+	 * Throws std::runtime_error if file can not be created
+	 */
+	TrajectoryRecorder(
+		const std::filesystem::path& filePath,
+		const TrajectoryOptions& options = {});
+	TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+	TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+	~TrajectoryRecorder();
+
+	/**
+	 * Call after every step, captures sim every stride steps
+	 */
+	void record(const Simulator& sim);
+
+	/**
+	 * Writes remaining frames and the index, rethrows errors of the writer
+	 * thread. Called by destructor, which ignores errors.
+	 */
+	void close();
+
+	inline size_t getRecordedFrames() const { return recordedFrames; }
+	inline size_t getDroppedFrames() const { return droppedFrames; }
+};
+
+#endif	// TRAJECTORY_RECORDER_HPP
@@ -2,8 +2,10 @@
 #ifndef UTIL_HPP
 #define UTIL_HPP
 
+#include <exception>
 #include <iostream>
 #include <limits>
+#include <string>
 
 #define newline std::endl
 inline void write(std::ostream&) {}
@@ -30,6 +32,21 @@ void writeF(std::ostream& out, const char* format, T t, Args... args) {
 template <typename T> inline void writeContainer(std::ostream& out, T t) {
 	for (auto& elem : t) write(out, elem, "");
 }
+/**
+ * Prints message of e and of exceptions nested in it, one per line
+ */
+inline void print_exception(const std::exception& e, int level = 0) {
+	std::cerr << std::string(level, ' ') << "exception: " << e.what() << '\n';
+	try {
+		std::rethrow_if_nested(e);
+	}
+	catch (const std::exception& e) {
+		print_exception(e, level + 1);
+	}
+	catch (...) {
+	}
+}
+
 #define NORMAL_IO_SPEEDUP \
 	std::ios_base::sync_with_stdio(false), std::cin.tie(NULL);
 
@@ -1,21 +1,53 @@
 #!/usr/bin/env python3
 # -*- coding: utf-8 -*-
 """
-Export objects as lines
+Export objects as chains, one per connected run of edges
 """
 
 import bpy
 
 C = bpy.context
 
+
+def chains(edges):
+    """
+    Splits edges into vertex paths. Paths start at vertices that do not join
+    exactly two edges, what is left are closed loops.
+    """
+    adjacent = {}
+    for index, edge in enumerate(edges):
+        for vertex in edge.vertices:
+            adjacent.setdefault(vertex, []).append(index)
+    used = set()
+
+    def walk(vertex, edge):
+        path = [vertex]
+        while edge is not None:
+            used.add(edge)
+            first, second = edges[edge].vertices
+            vertex = second if first == vertex else first
+            path.append(vertex)
+            edge = None
+            if len(adjacent[vertex]) == 2:
+                edge = next(
+                    (e for e in adjacent[vertex] if e not in used), None
+                )
+        return path
+
+    for vertex, joined in adjacent.items():
+        if len(joined) != 2:
+            for edge in joined:
+                if edge not in used:
+                    yield walk(vertex, edge)
+    for index, edge in enumerate(edges):
+        if index not in used:
+            yield walk(edge.vertices[0], index)
+
+
 for obj in C.selected_objects:
-    edges = obj.data.edges
     verts = obj.data.vertices
-    for edge in edges:
+    for path in chains(obj.data.edges):
         print(
-            "LINE",
-            verts[edge.vertices[1]].co.x,
-            verts[edge.vertices[1]].co.y,
-            verts[edge.vertices[0]].co.x,
-            verts[edge.vertices[0]].co.y,
+            "CHAIN",
+            *(f"{verts[v].co.x} {verts[v].co.y}" for v in path),
         )
@@ -0,0 +1,457 @@
+#include <PhysicsEngine2D/SceneFormat.hpp>
+#include <PhysicsEngine2D/Simulator.hpp>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+// Checkpoints store shapes in the flat records of binary scene files, with
+// the slot state of each SlotMap so handles survive a restore
+
+namespace {
+
+const char CHECKPOINT_MAGIC[4] = {'P', 'E', '2', 'K'};
+const uint32_t CHECKPOINT_VERSION = 5;
+const uint32_t CHECKPOINT_BYTE_ORDER = 0x01020304;
+
+struct CheckpointHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t subStep;
+	float restitutionCoeff, frictionCoeff, nBodyGravity;
+	uint32_t solverIterations;
+	double time;
+};
+
+// Slot without a position in baseShapes while a checkpoint is read
+const uint32_t NO_POSITION = std::numeric_limits<uint32_t>::max();
+
+enum OwnerType : uint32_t { LINES, PARTICLES, BALLS, BOXES, CHAINS };
+
+// Shape at a position of baseShapes, with its collision filter
+struct OwnerRecord {
+	uint32_t type;
+	uint32_t slot;
+	uint32_t category, mask;
+};
+
+struct EmitterState {
+	EmitterRecord emitter;
+	double pending;
+};
+
+// Manifolds decide reference faces and keep impulses, so continuing a
+// restored simulation needs them
+struct ManifoldRecord {
+	uint64_t first, second;
+	uint32_t segment, reserved;
+	ContactManifold manifold;
+};
+
+template <class T> void writeValue(std::ostream& out, const T& value) {
+	static_assert(std::is_trivially_copyable<T>::value, "");
+	out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+void writeVector(std::ostream& out, const std::vector<T>& values) {
+	static_assert(std::is_trivially_copyable<T>::value, "");
+	writeValue<uint64_t>(out, values.size());
+	out.write(
+		reinterpret_cast<const char*>(values.data()),
+		values.size() * sizeof(T));
+}
+
+template <class T> T readValue(std::istream& in) {
+	T value;
+	if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+		throw std::invalid_argument("Truncated checkpoint");
+	}
+	return value;
+}
+
+template <class T> std::vector<T> readVector(std::istream& in) {
+	// Grows in blocks, so a corrupt count fails at end of stream instead of
+	// allocating all of it
+	static const size_t BLOCK = size_t(1) << 16;
+	const uint64_t count = readValue<uint64_t>(in);
+	std::vector<T> values;
+	while (values.size() < count) {
+		const size_t start = values.size();
+		values.resize(start + std::min<uint64_t>(BLOCK, count - start));
+		if (!in.read(
+				reinterpret_cast<char*>(values.data() + start),
+				(values.size() - start) * sizeof(T))) {
+			throw std::invalid_argument("Truncated checkpoint");
+		}
+	}
+	return values;
+}
+
+template <class T, class Record, class ToRecord>
+void writeSlotMap(
+	std::ostream& out, const SlotMap<T>& map, ToRecord&& toRecord) {
+	std::vector<Record> records;
+	records.reserve(map.size());
+	for (const auto& value : map) {
+		records.push_back(toRecord(value));
+	}
+	writeVector(out, records);
+	writeVector(out, map.getValueSlots());
+	writeVector(out, map.getSlots());
+	writeValue(out, map.getFreeHead());
+}
+
+template <class T> struct SlotMapState {
+	std::vector<T> values;
+	std::vector<uint32_t> valueSlots;
+	std::vector<typename SlotMap<T>::Slot> slots;
+	uint32_t freeHead;
+
+	void restoreTo(SlotMap<T>& map) {
+		map.restore(
+			std::move(values), std::move(valueSlots), std::move(slots),
+			freeHead);
+	}
+};
+
+template <class T, class Record, class FromRecord>
+SlotMapState<T> readSlotMap(std::istream& in, FromRecord&& fromRecord) {
+	const auto records = readVector<Record>(in);
+	SlotMapState<T> state;
+	state.valueSlots = readVector<uint32_t>(in);
+	state.slots = readVector<typename SlotMap<T>::Slot>(in);
+	state.freeHead = readValue<uint32_t>(in);
+	if (!SlotMap<T>::isValidState(
+			records.size(), state.valueSlots, state.slots, state.freeHead)) {
+		throw std::invalid_argument("Inconsistent slots in checkpoint");
+	}
+	state.values.reserve(records.size());
+	for (const auto& record : records) {
+		state.values.push_back(fromRecord(record));
+	}
+	return state;
+}
+
+}  // namespace
+
+void Simulator::save(std::ostream& out) const {
+	std::vector<GravityRecord> fields;
+	for (const auto& field : forceFields) {
+		if (!field.isUniform()) {
+			throw std::invalid_argument(
+				"Force field with a custom function can not be saved");
+		}
+		fields.push_back(
+			{field.getAcceleration().x, field.getAcceleration().y});
+	}
+
+	CheckpointHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+	header.version = CHECKPOINT_VERSION;
+	header.byteOrder = CHECKPOINT_BYTE_ORDER;
+	header.subStep = subStep;
+	header.restitutionCoeff = restitutionCoeff;
+	header.frictionCoeff = frictionCoeff;
+	header.nBodyGravity = nBodyGravity;
+	header.solverIterations = solverIterations;
+	header.time = time;
+	writeValue(out, header);
+
+	writeSlotMap<Line, LineRecord>(out, lines.shapes, [](const Line& l) {
+		return LineRecord{l.start.x, l.start.y, l.end.x, l.end.y};
+	});
+	writeSlotMap<Particle, ParticleRecord>(
+		out, particles.shapes, [](const Particle& p) {
+			return ParticleRecord{p.mass,  p.rad,	p.pos.x,
+								  p.pos.y, p.vel.x, p.vel.y};
+		});
+	writeSlotMap<Ball, BallRecord>(out, balls.shapes, [](const Ball& b) {
+		return BallRecord{b.mass,  b.rad,	b.pos.x, b.pos.y,
+						  b.vel.x, b.vel.y, b.angle, b.angVel};
+	});
+	writeSlotMap<Box, BoxRecord>(out, boxes.shapes, [](const Box& b) {
+		return BoxRecord{b.mass,  b.w,	   b.h,		b.pos.x, b.pos.y,
+						 b.vel.x, b.vel.y, b.angle, b.angVel};
+	});
+	std::vector<VertexRecord> vertices;
+	for (const auto& chain : chains.shapes) {
+		for (const auto& vertex : chain.getVertices()) {
+			vertices.push_back({vertex.x, vertex.y});
+		}
+	}
+	writeVector(out, vertices);
+	uint64_t firstVertex = 0;
+	writeSlotMap<Chain, ChainRecord>(
+		out, chains.shapes, [&firstVertex](const Chain& c) {
+			const ChainRecord record{firstVertex, c.getVertices().size()};
+			firstVertex += record.vertexCount;
+			return record;
+		});
+
+	// Order of baseShapes decides order of collision pairs
+	std::vector<OwnerRecord> owners;
+	owners.reserve(baseShapeOwners.size());
+	for (size_t i = 0; i < baseShapeOwners.size(); i++) {
+		const auto& owner = baseShapeOwners[i];
+		const auto& shape = baseShapes[i].get();
+		const uint32_t type =
+			owner.basePositions == &lines.basePositions		  ? LINES
+			: owner.basePositions == &particles.basePositions ? PARTICLES
+			: owner.basePositions == &balls.basePositions	  ? BALLS
+			: owner.basePositions == &boxes.basePositions	  ? BOXES
+															  : CHAINS;
+		owners.push_back({type, owner.slot, shape.category, shape.mask});
+	}
+	writeVector(out, owners);
+	writeVector(out, fields);
+
+	writeSlotMap<ParticleEmitter, EmitterState>(
+		out, emitters, [](const ParticleEmitter& e) {
+			EmitterState state;
+			std::memset(&state, 0, sizeof(state));
+			state.emitter = {
+				e.rate,
+				e.mass.start,
+				e.mass.end,
+				e.radius.start,
+				e.radius.end,
+				e.position.rangeX.start,
+				e.position.rangeX.end,
+				e.position.rangeY.start,
+				e.position.rangeY.end,
+				e.velocity.rangeX.start,
+				e.velocity.rangeX.end,
+				e.velocity.rangeY.start,
+				e.velocity.rangeY.end,
+				e.lifetime.start,
+				e.lifetime.end,
+				0,
+				0};
+			state.pending = e.pending;
+			return state;
+		});
+	// Generator state is written in its portable text form
+	for (const auto& emitter : emitters) {
+		std::ostringstream gen;
+		gen << emitter.gen;
+		const auto text = gen.str();
+		writeVector(out, std::vector<char>(text.begin(), text.end()));
+	}
+	writeVector(out, expiries);
+
+	std::vector<ManifoldRecord> manifoldRecords(manifolds.size());
+	size_t i = 0;
+	for (const auto& [key, manifold] : manifolds) {
+		manifoldRecords[i].first = key.first;
+		manifoldRecords[i].second = key.second;
+		manifoldRecords[i].segment = key.segment;
+		manifoldRecords[i].reserved = 0;
+		manifoldRecords[i++].manifold = manifold;
+	}
+	writeValue(out, contactStep);
+	writeVector(out, manifoldRecords);
+
+	if (!out) {
+		throw std::runtime_error("Failed to write checkpoint");
+	}
+}
+
+void Simulator::load(std::istream& in) {
+	const auto header = readValue<CheckpointHeader>(in);
+	if (std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) !=
+		0) {
+		throw std::invalid_argument("Not a checkpoint");
+	}
+	if (header.byteOrder != CHECKPOINT_BYTE_ORDER) {
+		throw std::invalid_argument(
+			"Checkpoint was written with a different byte order");
+	}
+	if (header.version != CHECKPOINT_VERSION) {
+		throw std::invalid_argument(
+			"Unsupported checkpoint version " + std::to_string(header.version));
+	}
+
+	// Everything is read and checked before state is replaced
+	auto lineState = readSlotMap<Line, LineRecord>(in, [](const auto& l) {
+		return Line(Vector2D(l.x1, l.y1), Vector2D(l.x2, l.y2));
+	});
+	auto particleState =
+		readSlotMap<Particle, ParticleRecord>(in, [](const auto& p) {
+			return Particle(
+				Vector2D(p.x, p.y), Vector2D(p.vx, p.vy), p.mass, p.radius);
+		});
+	auto ballState = readSlotMap<Ball, BallRecord>(in, [](const auto& b) {
+		return Ball(
+			Vector2D(b.x, b.y), Vector2D(b.vx, b.vy), b.mass, b.radius,
+			b.angle, b.angularVelocity);
+	});
+	auto boxState = readSlotMap<Box, BoxRecord>(in, [](const auto& b) {
+		return Box(
+			Vector2D(b.x, b.y), Vector2D(b.vx, b.vy), b.mass, b.width,
+			b.height, b.angle, b.angularVelocity);
+	});
+	const auto vertices = readVector<VertexRecord>(in);
+	auto chainState = readSlotMap<Chain, ChainRecord>(
+		in, [&vertices](const ChainRecord& c) {
+			if (c.vertexCount < 2 || c.firstVertex > vertices.size() ||
+				c.vertexCount > vertices.size() - c.firstVertex) {
+				throw std::invalid_argument("Invalid chain in checkpoint");
+			}
+			std::vector<Vector2D> chainVertices;
+			chainVertices.reserve(c.vertexCount);
+			for (uint64_t i = 0; i < c.vertexCount; i++) {
+				const auto& v = vertices[c.firstVertex + i];
+				chainVertices.emplace_back(v.x, v.y);
+			}
+			return Chain(std::move(chainVertices));
+		});
+	const auto owners = readVector<OwnerRecord>(in);
+	const auto fields = readVector<GravityRecord>(in);
+	auto emitterState = readSlotMap<ParticleEmitter, EmitterState>(
+		in, [](const EmitterState& state) {
+			const auto& e = state.emitter;
+			ParticleEmitter emitter(
+				e.rate, Range<dataType>(e.massMin, e.massMax),
+				Range<dataType>(e.radMin, e.radMax),
+				Range2D<dataType>(e.xMin, e.xMax, e.yMin, e.yMax),
+				Range2D<dataType>(e.vxMin, e.vxMax, e.vyMin, e.vyMax),
+				Range<dataType>(e.lifeMin, e.lifeMax));
+			emitter.pending = state.pending;
+			return emitter;
+		});
+	for (auto& emitter : emitterState.values) {
+		const auto text = readVector<char>(in);
+		std::istringstream gen(std::string(text.begin(), text.end()));
+		if (!(gen >> emitter.gen)) {
+			throw std::invalid_argument("Invalid emitter state in checkpoint");
+		}
+	}
+	auto expiryState = readVector<Expiry>(in);
+	const auto savedContactStep = readValue<uint64_t>(in);
+	const auto manifoldRecords = readVector<ManifoldRecord>(in);
+	for (const auto& record : manifoldRecords) {
+		const auto& manifold = record.manifold;
+		if (manifold.pointCount > manifold.points.size() ||
+			manifold.axisOwner < -1 || manifold.axisOwner > 1 ||
+			manifold.axisEdge >= 4) {
+			throw std::invalid_argument("Invalid contact in checkpoint");
+		}
+	}
+
+	// Each shape must be at exactly one position of baseShapes
+	const size_t shapeCounts[] = {
+		lineState.values.size(), particleState.values.size(),
+		ballState.values.size(), boxState.values.size(),
+		chainState.values.size()};
+	const size_t slotCounts[] = {
+		lineState.slots.size(), particleState.slots.size(),
+		ballState.slots.size(), boxState.slots.size(),
+		chainState.slots.size()};
+	std::vector<uint32_t> basePositions[CHAINS + 1];
+	size_t shapeCount = 0;
+	for (uint32_t type = 0; type <= CHAINS; type++) {
+		basePositions[type].assign(slotCounts[type], NO_POSITION);
+		shapeCount += shapeCounts[type];
+	}
+	if (owners.size() != shapeCount) {
+		throw std::invalid_argument("Inconsistent shapes in checkpoint");
+	}
+	// Owners may only point at slots holding a shape, generation of those
+	// is odd
+	const auto isUsed = [&](uint32_t type, uint32_t slot) {
+		switch (type) {
+			case LINES:
+				return (lineState.slots[slot].generation & 1) != 0;
+			case PARTICLES:
+				return (particleState.slots[slot].generation & 1) != 0;
+			case BALLS:
+				return (ballState.slots[slot].generation & 1) != 0;
+			case BOXES:
+				return (boxState.slots[slot].generation & 1) != 0;
+			default:
+				return (chainState.slots[slot].generation & 1) != 0;
+		}
+	};
+	size_t ownerCounts[CHAINS + 1] = {};
+	for (size_t i = 0; i < owners.size(); i++) {
+		const auto& owner = owners[i];
+		if (owner.type > CHAINS || owner.slot >= slotCounts[owner.type] ||
+			!isUsed(owner.type, owner.slot) ||
+			basePositions[owner.type][owner.slot] != NO_POSITION) {
+			throw std::invalid_argument("Inconsistent shapes in checkpoint");
+		}
+		basePositions[owner.type][owner.slot] = i;
+		ownerCounts[owner.type]++;
+	}
+	for (uint32_t type = 0; type <= CHAINS; type++) {
+		if (ownerCounts[type] != shapeCounts[type]) {
+			throw std::invalid_argument("Inconsistent shapes in checkpoint");
+		}
+	}
+
+	subStep = header.subStep;
+	restitutionCoeff = header.restitutionCoeff;
+	frictionCoeff = header.frictionCoeff;
+	nBodyGravity = header.nBodyGravity;
+	solverIterations = header.solverIterations;
+	time = header.time;
+	lineState.restoreTo(lines.shapes);
+	particleState.restoreTo(particles.shapes);
+	ballState.restoreTo(balls.shapes);
+	boxState.restoreTo(boxes.shapes);
+	chainState.restoreTo(chains.shapes);
+	emitterState.restoreTo(emitters);
+	expiries = std::move(expiryState);
+	contactStep = savedContactStep;
+	manifolds.clear();
+	for (const auto& record : manifoldRecords) {
+		manifolds[{record.first, record.second, record.segment}] =
+			record.manifold;
+	}
+	forceFields.clear();
+	for (const auto& field : fields) {
+		forceFields.push_back(
+			ForceField::makeUniform(Vector2D(field.x, field.y)));
+	}
+
+	lines.basePositions = std::move(basePositions[LINES]);
+	particles.basePositions = std::move(basePositions[PARTICLES]);
+	balls.basePositions = std::move(basePositions[BALLS]);
+	boxes.basePositions = std::move(basePositions[BOXES]);
+	chains.basePositions = std::move(basePositions[CHAINS]);
+	baseShapes.clear();
+	baseShapeOwners.clear();
+	baseShapes.reserve(owners.size());
+	baseShapeOwners.reserve(owners.size());
+	auto addBaseShape = [this](auto& store, uint32_t slot) {
+		auto& shapes = store.shapes;
+		baseShapes.emplace_back(shapes.data()[shapes.getSlots()[slot].index]);
+		baseShapeOwners.push_back({&store.basePositions, slot, store.shapeId});
+	};
+	for (const auto& owner : owners) {
+		switch (owner.type) {
+			case LINES:
+				addBaseShape(lines, owner.slot);
+				break;
+			case PARTICLES:
+				addBaseShape(particles, owner.slot);
+				break;
+			case BALLS:
+				addBaseShape(balls, owner.slot);
+				break;
+			case BOXES:
+				addBaseShape(boxes, owner.slot);
+				break;
+			default:
+				addBaseShape(chains, owner.slot);
+				break;
+		}
+		baseShapes.back().get().category = owner.category;
+		baseShapes.back().get().mask = owner.mask;
+	}
+}
@@ -1,12 +1,14 @@
 #include <PhysicsEngine2D/Collisions.hpp>
 #include <PhysicsEngine2D/IntervalTree.hpp>
 
-std::vector<std::pair<int, int>> getCollisionBruteForce(
-	const std::vector<std::reference_wrapper<BaseShape>>& objects) {
-	std::vector<std::pair<int, int>> collisions;
+CollisionPairs getCollisionBruteForce(
+	const std::vector<std::reference_wrapper<BaseShape>>& objects,
+	std::pmr::memory_resource* memory) {
+	CollisionPairs collisions(memory);
 	for (size_t i = 0; i < objects.size(); i++) {
 		for (size_t j = i + 1; j < objects.size(); ++j) {
-			if (objects[i].get().intersects(objects[j])) {
+			if (objects[i].get().canCollide(objects[j]) &&
+				objects[i].get().intersects(objects[j])) {
 				collisions.emplace_back(i, j);
 			}
 		}
@@ -23,11 +25,12 @@ struct Temp {
 	}
 };
 
-std::vector<std::pair<int, int>> getCollisionBruteForceSAT(
-	const std::vector<std::reference_wrapper<BaseShape>>& objects) {
-	std::vector<std::pair<int, int>> collisions;
+CollisionPairs getCollisionBruteForceSAT(
+	const std::vector<std::reference_wrapper<BaseShape>>& objects,
+	std::pmr::memory_resource* memory) {
+	CollisionPairs collisions(memory);
 
-	std::vector<Temp> sortedObj(objects.size());
+	std::pmr::vector<Temp> sortedObj(objects.size(), memory);
 	for (size_t i = 0; i < objects.size(); i++) {
 		sortedObj[i].index = i;
 		sortedObj[i].val = objects[i].get().left;
@@ -39,7 +42,8 @@ std::vector<std::pair<int, int>> getCollisionBruteForceSAT(
 		auto& firstObj = objects[sortedObj[i].index].get();
 		for (size_t j = i + 1; j < sortedObj.size(); ++j) {
 			auto& secondObj = objects[sortedObj[j].index].get();
-			if (firstObj.intersects(secondObj)) {
+			if (firstObj.canCollide(secondObj) &&
+				firstObj.intersects(secondObj)) {
 				collisions.emplace_back(
 					std::minmax(sortedObj[i].index, sortedObj[j].index));
 			}
@@ -60,16 +64,19 @@ struct Event {
 	int index;
 };
 
+// Start events come first on ties so touching boxes are reported, same as
+// BaseShape::intersects
 inline bool operator<(const Event& a, const Event& b) {
 	return a.xCoord < b.xCoord ||
-		   (a.xCoord == b.xCoord && a.isStart < b.isStart);
+		   (a.xCoord == b.xCoord && a.isStart > b.isStart);
 }
 
-std::vector<std::pair<int, int>> getCollisionIntervalTree(
-	const std::vector<std::reference_wrapper<BaseShape>>& objects) {
-	std::vector<std::pair<int, int>> collisions;
-	AVL<double, int> st;
-	std::vector<Event> xEvents;
+CollisionPairs getCollisionIntervalTree(
+	const std::vector<std::reference_wrapper<BaseShape>>& objects,
+	std::pmr::memory_resource* memory) {
+	CollisionPairs collisions(memory);
+	AVL<double, int> st(memory);
+	std::pmr::vector<Event> xEvents(memory);
 
 	st.reserve(objects.size());
 	xEvents.resize(2 * objects.size());
@@ -86,32 +93,18 @@ std::vector<std::pair<int, int>> getCollisionIntervalTree(
 	std::sort(xEvents.begin(), xEvents.end());
 
 	for (auto& event : xEvents) {
+		auto& obj = objects[event.index].get();
 		if (event.isStart) {
-			auto list = st.searchAll(
-				objects[event.index].get().bottom,
-				objects[event.index].get().top);
-			for (auto& j : list) {
-				if (objects[event.index].get().intersects(objects[j]) &&
-					(objects[event.index].get().getClass() != LINE ||
-					 objects[j].get().getClass() != LINE)) {
-					if (event.index > j) {
-						collisions.emplace_back(j, event.index);
-					}
-					else {
-						collisions.emplace_back(event.index, j);
-					}
+			st.searchAll(obj.bottom, obj.top, [&](int j) {
+				if (obj.canCollide(objects[j]) && obj.intersects(objects[j])) {
+					collisions.emplace_back(std::minmax(j, event.index));
 				}
-			}
-			st.insert(
-				objects[event.index].get().bottom,
-				objects[event.index].get().top, event.index);
+			});
+			st.insert(obj.bottom, obj.top, event.index);
 		}
 		else {
-			st.remove(
-				objects[event.index].get().bottom,
-				objects[event.index].get().top, event.index);
+			st.remove(obj.bottom, obj.top, event.index);
 		}
-		// st.printTree();
 	}
 	return collisions;
 }
@@ -0,0 +1,531 @@
+#include <PhysicsEngine2D/Contact.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Reference face only changes if the other one is deeper by more than this
+const dataType FACE_TOLERANCE = 0.1f * CONTACT_SLOP;
+
+inline Vector2D edgeNormal(const Vector2D* vertices, int count, int edge) {
+	return (vertices[(edge + 1) % count] - vertices[edge]).rotate(-1, 0).unit();
+}
+
+/**
+ * Least distance of vertices of other in front of edge of polygon
+ */
+dataType edgeSeparation(
+	const Vector2D* polygon, int count, int edge, const Vector2D* other,
+	int otherCount) {
+	const auto normal = edgeNormal(polygon, count, edge);
+	dataType separation = std::numeric_limits<dataType>::max();
+	for (int i = 0; i < otherCount; i++) {
+		separation =
+			std::min(separation, normal.dot(other[i] - polygon[edge]));
+	}
+	return separation;
+}
+
+std::pair<dataType, int> maxSeparation(
+	const Vector2D* polygon, int count, const Vector2D* other, int otherCount) {
+	std::pair<dataType, int> best(-std::numeric_limits<dataType>::max(), 0);
+	for (int edge = 0; edge < count; edge++) {
+		const auto separation =
+			edgeSeparation(polygon, count, edge, other, otherCount);
+		if (separation > best.first) {
+			best = {separation, edge};
+		}
+	}
+	return best;
+}
+
+struct ClipVertex {
+	Vector2D point;
+	uint32_t id;
+};
+
+/**
+ * Keeps part of segment where normal.dot(point) <= offset, returns number
+ * of vertices left
+ */
+int clipSegment(
+	ClipVertex (&out)[2], const ClipVertex (&in)[2], const Vector2D& normal,
+	dataType offset, uint32_t clipId) {
+	int count = 0;
+	const dataType first = normal.dot(in[0].point) - offset,
+				   second = normal.dot(in[1].point) - offset;
+	if (first <= 0) out[count++] = in[0];
+	if (second <= 0) out[count++] = in[1];
+	if (first * second < 0) {
+		const dataType t = first / (first - second);
+		out[count++] = {
+			in[0].point + t * (in[1].point - in[0].point), clipId};
+	}
+	return count;
+}
+
+/**
+ * Keeps impulses of points whose features still touch
+ */
+void matchPoints(
+	ContactManifold& manifold, const std::array<ContactPoint, 2>& oldPoints,
+	int oldCount) {
+	for (int i = 0; i < manifold.pointCount; i++) {
+		auto& point = manifold.points[i];
+		for (int j = 0; j < oldCount; j++) {
+			if (oldPoints[j].id == point.id) {
+				point.normalImpulse = oldPoints[j].normalImpulse;
+				point.tangentImpulse = oldPoints[j].tangentImpulse;
+				break;
+			}
+		}
+	}
+}
+
+}  // namespace
+
+bool collidePolygons(
+	const Vector2D* first, int firstCount, const Vector2D* second,
+	int secondCount, ContactManifold& manifold) {
+	const auto oldPoints = manifold.points;
+	const int oldCount = manifold.pointCount;
+	manifold.pointCount = 0;
+
+	// Cached axis still separating is the common case of a broadphase pair
+	if (manifold.axisOwner >= 0) {
+		const auto separation =
+			manifold.axisOwner == 0
+				? edgeSeparation(
+					  first, firstCount, manifold.axisEdge, second,
+					  secondCount)
+				: edgeSeparation(
+					  second, secondCount, manifold.axisEdge, first,
+					  firstCount);
+		if (separation > 0) {
+			return false;
+		}
+	}
+	const auto [firstSeparation, firstEdge] =
+		maxSeparation(first, firstCount, second, secondCount);
+	if (firstSeparation > 0) {
+		manifold.axisOwner = 0;
+		manifold.axisEdge = firstEdge;
+		return false;
+	}
+	const auto [secondSeparation, secondEdge] =
+		maxSeparation(second, secondCount, first, firstCount);
+	if (secondSeparation > 0) {
+		manifold.axisOwner = 1;
+		manifold.axisEdge = secondEdge;
+		return false;
+	}
+
+	// Face of least overlap is the reference face, the previous one is kept
+	// unless the other is clearly better
+	const bool flip =
+		manifold.axisOwner == 1
+			? secondSeparation + FACE_TOLERANCE >= firstSeparation
+			: secondSeparation > firstSeparation + FACE_TOLERANCE;
+	const Vector2D* reference = flip ? second : first;
+	const Vector2D* incident = flip ? first : second;
+	const int referenceCount = flip ? secondCount : firstCount,
+			  incidentCount = flip ? firstCount : secondCount,
+			  referenceEdge = flip ? secondEdge : firstEdge;
+	const auto normal = edgeNormal(reference, referenceCount, referenceEdge);
+
+	// Incident edge faces most against the reference normal
+	int incidentEdge = 0;
+	dataType minDot = std::numeric_limits<dataType>::max();
+	for (int edge = 0; edge < incidentCount; edge++) {
+		const auto dot =
+			edgeNormal(incident, incidentCount, edge).dot(normal);
+		if (dot < minDot) {
+			minDot = dot;
+			incidentEdge = edge;
+		}
+	}
+	const int incidentNext = (incidentEdge + 1) % incidentCount;
+	const ClipVertex incidentSegment[2] = {
+		{incident[incidentEdge], uint32_t(incidentEdge)},
+		{incident[incidentNext], uint32_t(incidentNext)}};
+
+	// Clip incident edge to the sides of the reference edge
+	const auto& start = reference[referenceEdge];
+	const auto& end = reference[(referenceEdge + 1) % referenceCount];
+	const auto tangent = (end - start).unit();
+	ClipVertex clipped[2], clippedTwice[2];
+	if (clipSegment(
+			clipped, incidentSegment, -tangent, -tangent.dot(start), 0x80) <
+			2 ||
+		clipSegment(
+			clippedTwice, clipped, tangent, tangent.dot(end), 0x81) < 2) {
+		return false;
+	}
+
+	const uint32_t faceId = uint32_t(flip) << 16 | uint32_t(referenceEdge) << 8;
+	for (const auto& vertex : clippedTwice) {
+		const auto separation = normal.dot(vertex.point - start);
+		if (separation <= 0) {
+			auto& point = manifold.points[manifold.pointCount++];
+			point = ContactPoint();
+			point.point = vertex.point;
+			point.separation = separation;
+			point.id = faceId | vertex.id;
+		}
+	}
+	manifold.normal = flip ? -normal : normal;
+	manifold.axisOwner = flip;
+	manifold.axisEdge = referenceEdge;
+	matchPoints(manifold, oldPoints, oldCount);
+	return manifold.pointCount > 0;
+}
+
+bool collideCircles(
+	const Vector2D& firstCenter, dataType firstRadius,
+	const Vector2D& secondCenter, dataType secondRadius,
+	ContactManifold& manifold) {
+	const auto oldPoints = manifold.points;
+	const int oldCount = manifold.pointCount;
+	manifold.pointCount = 0;
+	const auto offset = secondCenter - firstCenter;
+	const dataType radius = firstRadius + secondRadius;
+	if (offset.lenSq() > radius * radius) {
+		return false;
+	}
+	const auto [distance, direction] = offset.getMagnitudeAndDirection();
+	// Concentric circles are pushed apart along any axis
+	manifold.normal = distance > 0 ? direction : Vector2D(0, 1);
+	auto& point = manifold.points[0];
+	point = ContactPoint();
+	point.point = firstCenter + firstRadius * manifold.normal;
+	point.separation = distance - radius;
+	manifold.pointCount = 1;
+	matchPoints(manifold, oldPoints, oldCount);
+	return true;
+}
+
+namespace {
+
+bool collideCircleSegment(
+	const Vector2D& center, dataType radius, const Vector2D& start,
+	const Vector2D& segment, dataType invLenSq, ContactManifold& manifold) {
+	const auto oldPoints = manifold.points;
+	const int oldCount = manifold.pointCount;
+	manifold.pointCount = 0;
+	const dataType param =
+		std::clamp((center - start).dot(segment) * invLenSq, 0.0f, 1.0f);
+	const auto closest = start + param * segment;
+	const auto offset = closest - center;
+	if (offset.lenSq() > radius * radius) {
+		return false;
+	}
+	const auto [distance, direction] = offset.getMagnitudeAndDirection();
+	auto& point = manifold.points[0];
+	point = ContactPoint();
+	// Center on the segment is pushed out along its normal
+	manifold.normal = distance > 0 ? direction : segment.rotate(-1, 0).unit();
+	point.point = closest;
+	point.separation = distance - radius;
+	// Ends of the segment and its inside are different features
+	point.id = param == 0 ? 1 : param == 1 ? 2 : 0;
+	manifold.pointCount = 1;
+	matchPoints(manifold, oldPoints, oldCount);
+	return true;
+}
+
+}  // namespace
+
+bool collideCircleSegment(
+	const Vector2D& center, dataType radius, const Vector2D& start,
+	const Vector2D& end, ContactManifold& manifold) {
+	const auto segment = end - start;
+	return collideCircleSegment(
+		center, radius, start, segment, 1 / segment.lenSq(), manifold);
+}
+
+bool collideCircleLine(
+	const Vector2D& center, dataType radius, const Line& line,
+	ContactManifold& manifold) {
+	return collideCircleSegment(
+		center, radius, line.start, line.direction, line.invLenSq, manifold);
+}
+
+size_t findTouchingPairs(const CircleLinePairs& pairs, uint32_t* touching) {
+	const size_t count = pairs.size();
+	size_t found = 0, i = 0;
+#if defined(__AVX__)
+	if constexpr (std::is_same<dataType, float>::value) {
+		const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1);
+		for (; i + 8 <= count; i += 8) {
+			const __m256 cx = _mm256_loadu_ps(&pairs.centerX[i]),
+						 cy = _mm256_loadu_ps(&pairs.centerY[i]),
+						 sx = _mm256_loadu_ps(&pairs.startX[i]),
+						 sy = _mm256_loadu_ps(&pairs.startY[i]),
+						 dx = _mm256_loadu_ps(&pairs.directionX[i]),
+						 dy = _mm256_loadu_ps(&pairs.directionY[i]);
+			// Closest point of the segment, as in collideCircleSegment
+			const __m256 param = _mm256_min_ps(
+				_mm256_max_ps(
+					_mm256_mul_ps(
+						_mm256_add_ps(
+							_mm256_mul_ps(_mm256_sub_ps(cx, sx), dx),
+							_mm256_mul_ps(_mm256_sub_ps(cy, sy), dy)),
+						_mm256_loadu_ps(&pairs.invLenSq[i])),
+					zero),
+				one);
+			const __m256 ox = _mm256_sub_ps(
+							 _mm256_add_ps(sx, _mm256_mul_ps(param, dx)), cx),
+						 oy = _mm256_sub_ps(
+							 _mm256_add_ps(sy, _mm256_mul_ps(param, dy)), cy);
+			const __m256 distSq = _mm256_add_ps(
+				_mm256_mul_ps(ox, ox), _mm256_mul_ps(oy, oy));
+			uint32_t mask = _mm256_movemask_ps(_mm256_cmp_ps(
+				distSq, _mm256_loadu_ps(&pairs.radiusSq[i]), _CMP_LE_OQ));
+			for (; mask; mask &= mask - 1) {
+				touching[found++] = i + __builtin_ctz(mask);
+			}
+		}
+	}
+#elif defined(__SSE__)
+	if constexpr (std::is_same<dataType, float>::value) {
+		const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1);
+		for (; i + 4 <= count; i += 4) {
+			const __m128 cx = _mm_loadu_ps(&pairs.centerX[i]),
+						 cy = _mm_loadu_ps(&pairs.centerY[i]),
+						 sx = _mm_loadu_ps(&pairs.startX[i]),
+						 sy = _mm_loadu_ps(&pairs.startY[i]),
+						 dx = _mm_loadu_ps(&pairs.directionX[i]),
+						 dy = _mm_loadu_ps(&pairs.directionY[i]);
+			const __m128 param = _mm_min_ps(
+				_mm_max_ps(
+					_mm_mul_ps(
+						_mm_add_ps(
+							_mm_mul_ps(_mm_sub_ps(cx, sx), dx),
+							_mm_mul_ps(_mm_sub_ps(cy, sy), dy)),
+						_mm_loadu_ps(&pairs.invLenSq[i])),
+					zero),
+				one);
+			const __m128 ox = _mm_sub_ps(
+							 _mm_add_ps(sx, _mm_mul_ps(param, dx)), cx),
+						 oy = _mm_sub_ps(
+							 _mm_add_ps(sy, _mm_mul_ps(param, dy)), cy);
+			const __m128 distSq =
+				_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy));
+			uint32_t mask = _mm_movemask_ps(
+				_mm_cmple_ps(distSq, _mm_loadu_ps(&pairs.radiusSq[i])));
+			for (; mask; mask &= mask - 1) {
+				touching[found++] = i + __builtin_ctz(mask);
+			}
+		}
+	}
+#endif
+	// Pairs left after the last full group
+	for (; i < count; i++) {
+		const Vector2D start(pairs.startX[i], pairs.startY[i]),
+			direction(pairs.directionX[i], pairs.directionY[i]),
+			center(pairs.centerX[i], pairs.centerY[i]);
+		const dataType param = std::clamp(
+			(center - start).dot(direction) * pairs.invLenSq[i], 0.0f, 1.0f);
+		if ((start + param * direction - center).lenSq() <=
+			pairs.radiusSq[i]) {
+			touching[found++] = i;
+		}
+	}
+	return found;
+}
+
+bool collideCircleChain(
+	const Vector2D& center, dataType radius, const Chain& chain,
+	uint32_t segment, ContactManifold& manifold) {
+	const auto& start = chain.segmentStart(segment);
+	if (!collideCircleSegment(
+			center, radius, start, chain.segmentEnd(segment), manifold)) {
+		return false;
+	}
+	const auto id = manifold.points[0].id;
+	const auto previous = chain.previous(segment);
+	bool owned = true;
+	if (id == 2) {
+		owned = chain.next(segment) == chain.segmentCount();
+	}
+	else if (id == 1 && previous != chain.segmentCount()) {
+		// Center projects onto the inside of the previous segment
+		const auto edge = start - chain.segmentStart(previous);
+		owned = edge.dot(start - center) <= 0;
+	}
+	if (!owned) {
+		manifold.pointCount = 0;
+	}
+	return owned;
+}
+
+bool collidePolygonChain(
+	const Vector2D* polygon, int count, const Chain& chain, uint32_t segment,
+	ContactManifold& manifold) {
+	const Vector2D vertices[] = {
+		chain.segmentStart(segment), chain.segmentEnd(segment)};
+	if (!collidePolygons(polygon, count, vertices, 2, manifold)) {
+		return false;
+	}
+	// Only a face of the polygon can touch a vertex of the segment
+	if (manifold.axisOwner != 0) {
+		return true;
+	}
+	const auto previous = chain.previous(segment);
+	int kept = 0;
+	for (int i = 0; i < manifold.pointCount; i++) {
+		const auto& point = manifold.points[i];
+		const uint32_t vertex = point.id & 0xFF;
+		bool owned = true;
+		if (vertex == 1) {
+			owned = chain.next(segment) == chain.segmentCount();
+		}
+		else if (vertex == 0 && previous != chain.segmentCount()) {
+			const auto towards = chain.segmentStart(previous) - vertices[0];
+			owned = manifold.normal.dot(towards) >= 0;
+		}
+		if (owned) {
+			manifold.points[kept++] = point;
+		}
+	}
+	manifold.pointCount = kept;
+	return kept > 0;
+}
+
+bool collideBoxCircle(
+	const Box& box, const Vector2D& center, dataType radius,
+	ContactManifold& manifold) {
+	const auto oldPoints = manifold.points;
+	const int oldCount = manifold.pointCount;
+	manifold.pointCount = 0;
+
+	// Center in frame of box
+	const Vector2D axisX(std::cos(box.angle), std::sin(box.angle)),
+		axisY = axisX.rotate(1, 0);
+	const auto offset = center - box.pos;
+	const Vector2D local(offset.dot(axisX), offset.dot(axisY));
+	const dataType halfW = 0.5 * box.w, halfH = 0.5 * box.h;
+	const Vector2D closest(
+		std::clamp(local.x, -halfW, halfW), std::clamp(local.y, -halfH, halfH));
+
+	Vector2D normal;
+	dataType separation;
+	auto& point = manifold.points[0];
+	point = ContactPoint();
+	if (closest.x != local.x || closest.y != local.y) {
+		const auto [distance, direction] =
+			(local - closest).getMagnitudeAndDirection();
+		if (distance > radius) {
+			return false;
+		}
+		normal = direction;
+		separation = distance - radius;
+		point.id = (closest.x == local.x) | (closest.y == local.y) << 1;
+	}
+	else {
+		// Center inside, pushed out through the nearest face
+		const dataType depthX = halfW - std::abs(local.x),
+					   depthY = halfH - std::abs(local.y);
+		if (depthX < depthY) {
+			normal = Vector2D(local.x < 0 ? -1 : 1, 0);
+			separation = -depthX - radius;
+		}
+		else {
+			normal = Vector2D(0, local.y < 0 ? -1 : 1);
+			separation = -depthY - radius;
+		}
+		point.id = 4;
+	}
+	manifold.normal = normal.x * axisX + normal.y * axisY;
+	point.point = box.pos + closest.x * axisX + closest.y * axisY;
+	point.separation = separation;
+	manifold.pointCount = 1;
+	matchPoints(manifold, oldPoints, oldCount);
+	return true;
+}
+
+void prepareContact(SolverContact& contact, dataType restitutionCoeff) {
+	auto& manifold = *contact.manifold;
+	const auto& normal = manifold.normal;
+	const auto tangent = normal.rotate(1, 0);
+	const auto &first = contact.first, &second = contact.second;
+	const dataType invMassSum = first.invMass() + second.invMass();
+	for (int i = 0; i < manifold.pointCount; i++) {
+		const auto& point = manifold.points[i];
+		const auto firstArm = first.arm(point.point),
+				   secondArm = second.arm(point.point);
+		const dataType firstNormalArm = firstArm.cross(normal),
+					   secondNormalArm = secondArm.cross(normal),
+					   firstTangentArm = firstArm.cross(tangent),
+					   secondTangentArm = secondArm.cross(tangent);
+		contact.normalMass[i] =
+			1 / (invMassSum +
+				 firstNormalArm * firstNormalArm * first.invInertia() +
+				 secondNormalArm * secondNormalArm * second.invInertia());
+		contact.tangentMass[i] =
+			1 / (invMassSum +
+				 firstTangentArm * firstTangentArm * first.invInertia() +
+				 secondTangentArm * secondTangentArm * second.invInertia());
+		const dataType normalSpeed =
+			(second.velocityAt(point.point) - first.velocityAt(point.point))
+				.dot(normal);
+		contact.velocityBias[i] = normalSpeed < -RESTITUTION_THRESHOLD
+									  ? -restitutionCoeff * normalSpeed
+									  : 0;
+	}
+}
+
+void warmStartContact(SolverContact& contact) {
+	auto& manifold = *contact.manifold;
+	const auto tangent = manifold.normal.rotate(1, 0);
+	for (int i = 0; i < manifold.pointCount; i++) {
+		const auto& point = manifold.points[i];
+		const auto impulse = point.normalImpulse * manifold.normal +
+							 point.tangentImpulse * tangent;
+		contact.first.applyImpulse(-impulse, point.point);
+		contact.second.applyImpulse(impulse, point.point);
+	}
+}
+
+void solveContact(SolverContact& contact, dataType frictionCoeff) {
+	auto& manifold = *contact.manifold;
+	const auto& normal = manifold.normal;
+	const auto tangent = normal.rotate(1, 0);
+	auto &first = contact.first, &second = contact.second;
+	for (int i = 0; i < manifold.pointCount; i++) {
+		auto& point = manifold.points[i];
+
+		// Friction first, it is bounded by the last normal impulse
+		auto relativeVel =
+			second.velocityAt(point.point) - first.velocityAt(point.point);
+		const dataType maxFriction = frictionCoeff * point.normalImpulse;
+		const dataType tangentImpulse = std::clamp(
+			point.tangentImpulse -
+				relativeVel.dot(tangent) * contact.tangentMass[i],
+			-maxFriction, maxFriction);
+		const auto tangentDelta =
+			(tangentImpulse - point.tangentImpulse) * tangent;
+		point.tangentImpulse = tangentImpulse;
+		first.applyImpulse(-tangentDelta, point.point);
+		second.applyImpulse(tangentDelta, point.point);
+
+		relativeVel =
+			second.velocityAt(point.point) - first.velocityAt(point.point);
+		const dataType normalImpulse = std::max(
+			point.normalImpulse + (contact.velocityBias[i] -
+								   relativeVel.dot(normal)) *
+									  contact.normalMass[i],
+			0.0f);
+		const auto normalDelta = (normalImpulse - point.normalImpulse) * normal;
+		point.normalImpulse = normalImpulse;
+		first.applyImpulse(-normalDelta, point.point);
+		second.applyImpulse(normalDelta, point.point);
+	}
+}
@@ -0,0 +1,65 @@
+#include <PhysicsEngine2D/FrameArena.hpp>
+#include <algorithm>
+#include <cstdint>
+
+FrameArena::FrameArena(
+	size_t initialSize, std::pmr::memory_resource* upstream)
+	: upstream(upstream) {
+	addChunk(std::max<size_t>(initialSize, 64));
+}
+
+FrameArena::~FrameArena() { releaseChunks(); }
+
+void FrameArena::addChunk(size_t size) {
+	chunks.push_back(
+		{static_cast<std::byte*>(
+			 upstream->allocate(size, alignof(std::max_align_t))),
+		 size});
+}
+
+void FrameArena::releaseChunks() {
+	for (auto& chunk : chunks) {
+		upstream->deallocate(chunk.data, chunk.size, alignof(std::max_align_t));
+	}
+	chunks.clear();
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+	while (true) {
+		auto& chunk = chunks[current];
+		// Align address, chunks are only aligned to max_align_t
+		const uintptr_t base = reinterpret_cast<uintptr_t>(chunk.data);
+		const size_t start =
+			((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+		if (start + bytes <= chunk.size) {
+			used += start + bytes - offset;
+			peak = std::max(peak, used);
+			offset = start + bytes;
+			return chunk.data + start;
+		}
+		// Tail of current chunk is left unused until reset
+		used += chunk.size - offset;
+		if (current + 1 == chunks.size()) {
+			addChunk(std::max(2 * chunk.size, bytes + alignment));
+		}
+		current++;
+		offset = 0;
+	}
+}
+
+void FrameArena::reset() {
+	if (current > 0) {
+		const size_t total = capacity();
+		releaseChunks();
+		addChunk(total);
+	}
+	current = 0;
+	offset = 0;
+	used = 0;
+}
+
+size_t FrameArena::capacity() const {
+	size_t total = 0;
+	for (auto& chunk : chunks) total += chunk.size;
+	return total;
+}
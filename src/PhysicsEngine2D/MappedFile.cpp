@@ -0,0 +1,84 @@
+#include <PhysicsEngine2D/MappedFile.hpp>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::filesystem::path& filePath) {
+	const int fd = open(filePath.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Unable to open " + filePath.string());
+	}
+	struct stat status;
+	if (fstat(fd, &status) != 0) {
+		close(fd);
+		throw std::runtime_error("Unable to stat " + filePath.string());
+	}
+	length = status.st_size;
+	if (length > 0) {
+		void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (address == MAP_FAILED) {
+			close(fd);
+			throw std::runtime_error("Unable to map " + filePath.string());
+		}
+		begin = static_cast<const char*>(address);
+	}
+	// Mapping stays valid after descriptor is closed
+	close(fd);
+}
+
+void MappedFile::unmap() {
+	if (begin != nullptr) {
+		munmap(const_cast<char*>(begin), length);
+	}
+	begin = nullptr;
+	length = 0;
+}
+
+#else
+#include <fstream>
+
+MappedFile::MappedFile(const std::filesystem::path& filePath) {
+	std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+	if (!file) {
+		throw std::runtime_error("Unable to open " + filePath.string());
+	}
+	buffer.resize(file.tellg());
+	file.seekg(0);
+	file.read(buffer.data(), buffer.size());
+	begin = buffer.data();
+	length = buffer.size();
+}
+
+void MappedFile::unmap() {
+	buffer.clear();
+	begin = nullptr;
+	length = 0;
+}
+#endif
+
+MappedFile::MappedFile(MappedFile&& that) noexcept
+	: begin(std::exchange(that.begin, nullptr)),
+	  length(std::exchange(that.length, 0)) {
+#if !defined(__unix__) && !defined(__APPLE__)
+	buffer = std::move(that.buffer);
+#endif
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& that) noexcept {
+	if (this != &that) {
+		unmap();
+		begin = std::exchange(that.begin, nullptr);
+		length = std::exchange(that.length, 0);
+#if !defined(__unix__) && !defined(__APPLE__)
+		buffer = std::move(that.buffer);
+#endif
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile() { unmap(); }
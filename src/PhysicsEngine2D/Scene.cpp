@@ -0,0 +1,246 @@
+#include <PhysicsEngine2D/MappedFile.hpp>
+#include <PhysicsEngine2D/Scene.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+SceneInfo addScene(const SceneView& scene, Simulator& sim) {
+	sim.clear();
+	sim.reserve(
+		scene.lines.size(), scene.particles.size(), scene.balls.size(),
+		scene.boxes.size());
+	for (const auto& l : scene.lines) {
+		sim.addLine(Vector2D(l.x1, l.y1), Vector2D(l.x2, l.y2));
+	}
+	for (const auto& p : scene.particles) {
+		sim.addParticle(
+			Vector2D(p.x, p.y), Vector2D(p.vx, p.vy), p.mass, p.radius);
+	}
+	for (const auto& b : scene.balls) {
+		sim.addBall(
+			Vector2D(b.x, b.y), Vector2D(b.vx, b.vy), b.mass, b.radius,
+			b.angle, b.angularVelocity);
+	}
+	for (const auto& b : scene.boxes) {
+		sim.addBox(
+			Vector2D(b.x, b.y), Vector2D(b.vx, b.vy), b.mass, b.width,
+			b.height, b.angle, b.angularVelocity);
+	}
+	std::vector<Vector2D> vertices;
+	for (const auto& c : scene.chains) {
+		vertices.clear();
+		const auto first = scene.vertices.begin() + c.firstVertex;
+		for (auto v = first; v != first + c.vertexCount; ++v) {
+			vertices.emplace_back(v->x, v->y);
+		}
+		sim.addChain(vertices);
+	}
+	for (const auto& g : scene.gravities) {
+		sim.addForceField(ForceField::makeUniform(Vector2D(g.x, g.y)));
+	}
+	for (const auto& e : scene.emitters) {
+		sim.addEmitter(ParticleEmitter(
+			e.rate, Range<dataType>(e.massMin, e.massMax),
+			Range<dataType>(e.radMin, e.radMax),
+			Range2D<dataType>(e.xMin, e.xMax, e.yMin, e.yMax),
+			Range2D<dataType>(e.vxMin, e.vxMax, e.vyMin, e.vyMax),
+			Range<dataType>(e.lifeMin, e.lifeMax), e.seed));
+	}
+	return scene.info;
+}
+
+SceneInfo loadScene(std::istream& in, Simulator& sim, uint32_t seed) {
+	const auto scene = parseScene(in, seed);
+	return addScene(scene.view(), sim);
+}
+
+SceneInfo loadScene(
+	const std::filesystem::path& filePath, Simulator& sim, uint32_t seed) {
+	SceneInfo info;
+	const MappedFile file(filePath);
+	if (isBinaryScene(file.data(), file.size())) {
+		info = addScene(readBinaryScene(file.data(), file.size()), sim);
+	}
+	else {
+		const auto scene = parseScene(file.data(), file.size(), seed);
+		info = addScene(scene.view(), sim);
+	}
+	if (info.title.empty()) {
+		info.title = filePath.filename().string();
+	}
+	return info;
+}
+
+void writeScene(std::ostream& out, const Simulator& sim) {
+	const auto precision =
+		out.precision(std::numeric_limits<double>::max_digits10);
+	for (const auto& line : sim.getLines()) {
+		out << "LINE " << line.start.x << " " << line.start.y << " "
+			<< line.end.x << " " << line.end.y << "\n";
+	}
+	for (const auto& chain : sim.getChains()) {
+		out << "CHAIN";
+		for (const auto& vertex : chain.getVertices()) {
+			out << " " << vertex.x << " " << vertex.y;
+		}
+		out << "\n";
+	}
+	for (const auto& particle : sim.getParticles()) {
+		out << "PARTICLE " << particle.mass << " " << particle.rad << " "
+			<< particle.pos.x << " " << particle.pos.y << " " << particle.vel.x
+			<< " " << particle.vel.y << "\n";
+	}
+	for (const auto& ball : sim.getBalls()) {
+		out << "BALL " << ball.mass << " " << ball.rad << " " << ball.pos.x
+			<< " " << ball.pos.y << " " << ball.vel.x << " " << ball.vel.y
+			<< " " << ball.angle << " " << ball.angVel << "\n";
+	}
+	for (const auto& box : sim.getBoxes()) {
+		out << "BOX " << box.mass << " " << box.w << " " << box.h << " "
+			<< box.pos.x << " " << box.pos.y << " " << box.vel.x << " "
+			<< box.vel.y << " " << box.angle << " " << box.angVel << "\n";
+	}
+	for (const auto& emitter : sim.getEmitters()) {
+		out << "EMITTER " << emitter.rate << " " << emitter.mass.start << " "
+			<< emitter.mass.end << " " << emitter.radius.start << " "
+			<< emitter.radius.end << " " << emitter.position.rangeX.start
+			<< " " << emitter.position.rangeX.end << " "
+			<< emitter.position.rangeY.start << " "
+			<< emitter.position.rangeY.end << " "
+			<< emitter.velocity.rangeX.start << " "
+			<< emitter.velocity.rangeX.end << " "
+			<< emitter.velocity.rangeY.start << " "
+			<< emitter.velocity.rangeY.end << " " << emitter.lifetime.start
+			<< " " << emitter.lifetime.end << "\n";
+	}
+	out.precision(precision);
+}
+
+static const uint64_t SECTION_ALIGNMENT = 8;
+
+void writeBinaryScene(std::ostream& out, const SceneView& scene) {
+	SceneFileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::copy(
+		SCENE_FILE_MAGIC, SCENE_FILE_MAGIC + sizeof(SCENE_FILE_MAGIC),
+		header.magic);
+	header.version = SCENE_FILE_VERSION;
+	header.byteOrder = SCENE_FILE_BYTE_ORDER;
+	header.width = scene.info.width;
+	header.height = scene.info.height;
+	header.left = scene.info.topLeft.x;
+	header.top = scene.info.topLeft.y;
+	header.right = scene.info.bottomRight.x;
+	header.bottom = scene.info.bottomRight.y;
+
+	struct Section {
+		SceneFileSection& location;
+		const void* data;
+		size_t bytes;
+	};
+	const Section sections[] = {
+		{header.title, scene.info.title.data(), scene.info.title.size()},
+		{header.lines, scene.lines.begin(),
+		 scene.lines.size() * sizeof(LineRecord)},
+		{header.particles, scene.particles.begin(),
+		 scene.particles.size() * sizeof(ParticleRecord)},
+		{header.balls, scene.balls.begin(),
+		 scene.balls.size() * sizeof(BallRecord)},
+		{header.boxes, scene.boxes.begin(),
+		 scene.boxes.size() * sizeof(BoxRecord)},
+		{header.gravities, scene.gravities.begin(),
+		 scene.gravities.size() * sizeof(GravityRecord)},
+		{header.emitters, scene.emitters.begin(),
+		 scene.emitters.size() * sizeof(EmitterRecord)},
+		{header.chains, scene.chains.begin(),
+		 scene.chains.size() * sizeof(ChainRecord)},
+		{header.vertices, scene.vertices.begin(),
+		 scene.vertices.size() * sizeof(VertexRecord)},
+	};
+	const size_t counts[] = {
+		scene.info.title.size(), scene.lines.size(),
+		scene.particles.size(),	 scene.balls.size(),
+		scene.boxes.size(),		 scene.gravities.size(),
+		scene.emitters.size(),	 scene.chains.size(),
+		scene.vertices.size()};
+
+	uint64_t offset = sizeof(header);
+	for (size_t i = 0; i < std::size(sections); i++) {
+		offset = (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT *
+				 SECTION_ALIGNMENT;
+		sections[i].location = {offset, counts[i]};
+		offset += sections[i].bytes;
+	}
+
+	static const char padding[SECTION_ALIGNMENT] = {};
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	uint64_t written = sizeof(header);
+	for (const auto& section : sections) {
+		out.write(padding, section.location.offset - written);
+		out.write(static_cast<const char*>(section.data), section.bytes);
+		written = section.location.offset + section.bytes;
+	}
+}
+
+template <class T>
+static RecordSpan<T> getSection(
+	const char* data, size_t size, const SceneFileSection& section) {
+	if (section.offset % alignof(T) != 0 || section.offset > size ||
+		section.count > (size - section.offset) / sizeof(T)) {
+		throw std::invalid_argument("Binary scene section out of bounds");
+	}
+	if (reinterpret_cast<uintptr_t>(data + section.offset) % alignof(T) != 0) {
+		throw std::invalid_argument("Binary scene data is not aligned");
+	}
+	return {reinterpret_cast<const T*>(data + section.offset), section.count};
+}
+
+SceneView readBinaryScene(const char* data, size_t size) {
+	if (size < SCENE_FILE_V1_HEADER_SIZE || !isBinaryScene(data, size)) {
+		throw std::invalid_argument("Not a binary scene");
+	}
+	SceneFileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(&header, data, SCENE_FILE_V1_HEADER_SIZE);
+	if (header.byteOrder != SCENE_FILE_BYTE_ORDER) {
+		throw std::invalid_argument(
+			"Binary scene was written with a different byte order");
+	}
+	if (header.version == 0 || header.version > SCENE_FILE_VERSION) {
+		throw std::invalid_argument(
+			"Unsupported binary scene version " +
+			std::to_string(header.version));
+	}
+	if (header.version >= 2) {
+		if (size < sizeof(SceneFileHeader)) {
+			throw std::invalid_argument("Not a binary scene");
+		}
+		std::memcpy(&header, data, sizeof(header));
+	}
+
+	SceneView scene;
+	const auto title = getSection<char>(data, size, header.title);
+	scene.info.title.assign(title.begin(), title.end());
+	scene.info.width = header.width;
+	scene.info.height = header.height;
+	scene.info.topLeft = Vector2D(header.left, header.top);
+	scene.info.bottomRight = Vector2D(header.right, header.bottom);
+	scene.lines = getSection<LineRecord>(data, size, header.lines);
+	scene.particles = getSection<ParticleRecord>(data, size, header.particles);
+	scene.balls = getSection<BallRecord>(data, size, header.balls);
+	scene.boxes = getSection<BoxRecord>(data, size, header.boxes);
+	scene.gravities = getSection<GravityRecord>(data, size, header.gravities);
+	scene.emitters = getSection<EmitterRecord>(data, size, header.emitters);
+	scene.chains = getSection<ChainRecord>(data, size, header.chains);
+	scene.vertices = getSection<VertexRecord>(data, size, header.vertices);
+	for (const auto& chain : scene.chains) {
+		if (chain.vertexCount < 2 ||
+			chain.firstVertex > scene.vertices.size() ||
+			chain.vertexCount > scene.vertices.size() - chain.firstVertex) {
+			throw std::invalid_argument("Binary scene chain out of bounds");
+		}
+	}
+	return scene;
+}
@@ -0,0 +1,401 @@
+#include <PhysicsEngine2D/Scene.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+namespace {
+
+/**
+ * Whitespace separated fields of one line of a scene
+ */
+class Fields {
+	const char* next;
+	const char* end;
+
+	static inline bool isSpace(char c) {
+		return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+	}
+
+   public:
+	Fields(const char* begin, const char* end) : next(begin), end(end) {}
+
+	/**
+	 * Returns next field, empty at end of line or at a field starting with #
+	 */
+	std::string_view get() {
+		while (next != end && isSpace(*next)) next++;
+		const char* start = next;
+		while (next != end && !isSpace(*next)) next++;
+		if (start != next && *start == '#') {
+			next = end;
+			return {};
+		}
+		return {start, size_t(next - start)};
+	}
+
+	/**
+	 * Returns rest of line without surrounding whitespace
+	 */
+	std::string_view rest() {
+		while (next != end && isSpace(*next)) next++;
+		const char* last = end;
+		while (last != next && isSpace(*(last - 1))) last--;
+		std::string_view text(next, last - next);
+		next = end;
+		return text;
+	}
+};
+
+/**
+ * Parses whole field with std::from_chars, which unlike streams ignores
+ * locale and does not allocate
+ */
+template <typename T> bool parseField(std::string_view field, T& value) {
+	const char* first = field.data();
+	const char* last = field.data() + field.size();
+	// Accepted by streams, but not by from_chars
+	if (first != last && *first == '+') {
+		first++;
+	}
+	const auto [ptr, ec] = std::from_chars(first, last, value);
+	return first != last && ec == std::errc() && ptr == last;
+}
+
+template <typename... T> bool parseFields(Fields& fields, T&... values) {
+	return (parseField(fields.get(), values) && ...);
+}
+
+/**
+ * Returns false if fields have ended, throws if next field is not a number
+ */
+template <typename T>
+bool parseOptional(Fields& fields, T& value, const char* error) {
+	const auto field = fields.get();
+	if (field.empty()) {
+		return false;
+	}
+	if (!parseField(field, value)) {
+		throw std::invalid_argument(error);
+	}
+	return true;
+}
+
+/**
+ * Item whose records depend on the random generator, which has to be drawn
+ * in file order after all chunks are parsed
+ */
+struct RandomItem {
+	enum Type { REPEAT_PARTICLE, EMITTER_SEED } type;
+	// Number of particles of the chunk before this item
+	size_t particleIndex;
+	int count;
+	double massMin, massMax, radMin, radMax, xMin, xMax, yMin, yMax;
+};
+
+struct SceneChunk {
+	// Particles without REPEAT items, emitters without seeds
+	SceneData records;
+	std::vector<RandomItem> randomItems;
+	bool hasSize = false, hasTitle = false;
+	// Set if END was reached, later chunks are ignored
+	bool ended = false;
+	size_t lineCount = 0;
+	// First error of chunk, parsing of chunk stops there
+	std::exception_ptr error;
+};
+
+void parseLine(Fields& fields, std::string_view type, SceneChunk& chunk) {
+	auto& scene = chunk.records;
+	if (type == "LINE") {
+		LineRecord l;
+		if (!parseFields(fields, l.x1, l.y1, l.x2, l.y2)) {
+			throw std::invalid_argument("Invalid 'LINE' input");
+		}
+		scene.lines.push_back(l);
+	}
+	else if (type == "CHAIN") {
+		ChainRecord c{scene.vertices.size(), 0};
+		VertexRecord v;
+		while (parseOptional(fields, v.x, "Invalid 'CHAIN' input")) {
+			if (!parseFields(fields, v.y)) {
+				throw std::invalid_argument("Invalid 'CHAIN' input");
+			}
+			// Repeated vertex would make a segment of zero length
+			if (c.vertexCount > 0 && scene.vertices.back().x == v.x &&
+				scene.vertices.back().y == v.y) {
+				continue;
+			}
+			scene.vertices.push_back(v);
+			c.vertexCount++;
+		}
+		if (c.vertexCount < 2) {
+			throw std::invalid_argument("Invalid 'CHAIN' input");
+		}
+		scene.chains.push_back(c);
+	}
+	else if (type == "PARTICLE") {
+		ParticleRecord p{1, 1, 0, 0, 0, 0};
+		if (!parseFields(fields, p.mass, p.radius, p.x, p.y)) {
+			throw std::invalid_argument("Invalid 'PARTICLE' input");
+		}
+		if (parseOptional(fields, p.vx, "Invalid 'PARTICLE' input")) {
+			if (!parseFields(fields, p.vy)) {
+				throw std::invalid_argument("Invalid 'PARTICLE' input");
+			}
+		}
+		scene.particles.push_back(p);
+	}
+	else if (type == "BALL") {
+		BallRecord b{1, 1, 0, 0, 0, 0, 0, 0};
+		if (!parseFields(fields, b.mass, b.radius, b.x, b.y)) {
+			throw std::invalid_argument("Invalid 'BALL' input");
+		}
+		if (parseOptional(fields, b.vx, "Invalid 'BALL' input")) {
+			if (!parseFields(fields, b.vy)) {
+				throw std::invalid_argument("Invalid 'BALL' input");
+			}
+			if (parseOptional(fields, b.angle, "Invalid 'BALL' input")) {
+				parseOptional(
+					fields, b.angularVelocity, "Invalid 'BALL' input");
+			}
+		}
+		scene.balls.push_back(b);
+	}
+	else if (type == "BOX") {
+		BoxRecord b{1, 1, 1, 0, 0, 0, 0, 0, 0};
+		if (!parseFields(fields, b.mass, b.width, b.height, b.x, b.y)) {
+			throw std::invalid_argument("Invalid 'BOX' input");
+		}
+		if (parseOptional(fields, b.vx, "Invalid 'BOX' input")) {
+			if (!parseFields(fields, b.vy)) {
+				throw std::invalid_argument("Invalid 'BOX' input");
+			}
+			if (parseOptional(fields, b.angle, "Invalid 'BOX' input")) {
+				parseOptional(fields, b.angularVelocity, "Invalid 'BOX' input");
+			}
+		}
+		scene.boxes.push_back(b);
+	}
+	else if (type == "GRAVITY") {
+		GravityRecord g;
+		if (!parseFields(fields, g.x, g.y)) {
+			throw std::invalid_argument("Invalid 'GRAVITY' input");
+		}
+		scene.gravities.push_back(g);
+	}
+	else if (type == "SIZE") {
+		unsigned W, H;
+		double left, top, right, bottom;
+		if (!parseFields(fields, W, H, left, top, right, bottom)) {
+			throw std::invalid_argument("Invalid 'SIZE' input");
+		}
+		scene.info.width = W;
+		scene.info.height = H;
+		scene.info.topLeft = Vector2D(left, top);
+		scene.info.bottomRight = Vector2D(right, bottom);
+		chunk.hasSize = true;
+	}
+	else if (type == "TITLE") {
+		scene.info.title = fields.rest();
+		chunk.hasTitle = true;
+	}
+	else if (type == "REPEAT") {
+		RandomItem item;
+		item.type = RandomItem::REPEAT_PARTICLE;
+		item.particleIndex = scene.particles.size();
+		if (!parseFields(fields, item.count)) {
+			throw std::invalid_argument("Invalid 'REPEAT' input");
+		}
+		const auto itemType = fields.get();
+		if (itemType.empty()) {
+			throw std::invalid_argument("Invalid 'REPEAT' input");
+		}
+		if (itemType == "PARTICLE") {
+			if (!parseFields(
+					fields, item.massMin, item.massMax, item.radMin,
+					item.radMax, item.xMin, item.xMax, item.yMin, item.yMax)) {
+				throw std::invalid_argument("Invalid 'REPEAT' input");
+			}
+			chunk.randomItems.push_back(item);
+		}
+	}
+	else if (type == "EMITTER") {
+		EmitterRecord e{};
+		if (!parseFields(
+				fields, e.rate, e.massMin, e.massMax, e.radMin, e.radMax,
+				e.xMin, e.xMax, e.yMin, e.yMax)) {
+			throw std::invalid_argument("Invalid 'EMITTER' input");
+		}
+		e.lifeMin = e.lifeMax = std::numeric_limits<double>::infinity();
+		if (parseOptional(fields, e.vxMin, "Invalid 'EMITTER' input")) {
+			if (!parseFields(fields, e.vxMax, e.vyMin, e.vyMax)) {
+				throw std::invalid_argument("Invalid 'EMITTER' input");
+			}
+			if (parseOptional(fields, e.lifeMin, "Invalid 'EMITTER' input")) {
+				if (!parseFields(fields, e.lifeMax)) {
+					throw std::invalid_argument("Invalid 'EMITTER' input");
+				}
+			}
+		}
+		RandomItem item;
+		item.type = RandomItem::EMITTER_SEED;
+		item.particleIndex = scene.particles.size();
+		chunk.randomItems.push_back(item);
+		scene.emitters.push_back(e);
+	}
+	else if (type == "END") {
+		chunk.ended = true;
+	}
+}
+
+void parseChunk(const char* begin, const char* end, SceneChunk& chunk) {
+	while (begin != end && !chunk.ended) {
+		const char* lineBreak =
+			static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+		const char* lineEnd = lineBreak ? lineBreak : end;
+		chunk.lineCount++;
+		Fields fields(begin, lineEnd);
+		const auto type = fields.get();
+		if (!type.empty()) {
+			try {
+				parseLine(fields, type, chunk);
+			}
+			catch (const std::exception&) {
+				chunk.error = std::current_exception();
+				return;
+			}
+		}
+		begin = lineBreak ? lineBreak + 1 : end;
+	}
+}
+
+/**
+ * Concatenates records of chunks in file order, expanding REPEAT items and
+ * seeding emitters with the same draws as a sequential parse
+ */
+SceneData mergeChunks(std::vector<SceneChunk>& chunks, uint32_t seed) {
+	SceneData scene;
+	std::mt19937 gen(seed);
+
+	size_t lineCount = 0;
+	auto append = [](auto& to, const auto& from) {
+		to.insert(to.end(), from.begin(), from.end());
+	};
+	for (auto& chunk : chunks) {
+		auto& records = chunk.records;
+		if (chunk.hasSize) {
+			scene.info.width = records.info.width;
+			scene.info.height = records.info.height;
+			scene.info.topLeft = records.info.topLeft;
+			scene.info.bottomRight = records.info.bottomRight;
+		}
+		if (chunk.hasTitle) {
+			scene.info.title = std::move(records.info.title);
+		}
+		append(scene.lines, records.lines);
+		append(scene.balls, records.balls);
+		append(scene.boxes, records.boxes);
+		append(scene.gravities, records.gravities);
+		// Vertices of chunk follow those of earlier chunks
+		for (auto chain : records.chains) {
+			chain.firstVertex += scene.vertices.size();
+			scene.chains.push_back(chain);
+		}
+		append(scene.vertices, records.vertices);
+
+		size_t copied = 0, emitter = 0;
+		auto copyParticles = [&](size_t until) {
+			scene.particles.insert(
+				scene.particles.end(), records.particles.begin() + copied,
+				records.particles.begin() + until);
+			copied = until;
+		};
+		for (const auto& item : chunk.randomItems) {
+			copyParticles(item.particleIndex);
+			if (item.type == RandomItem::EMITTER_SEED) {
+				records.emitters[emitter].seed = gen();
+				scene.emitters.push_back(records.emitters[emitter++]);
+				continue;
+			}
+			std::uniform_real_distribution<> mass(item.massMin, item.massMax);
+			std::uniform_real_distribution<> rad(item.radMin, item.radMax);
+			std::uniform_real_distribution<> x(item.xMin, item.xMax);
+			std::uniform_real_distribution<> y(item.yMin, item.yMax);
+			for (int i = 0; i < item.count; i++) {
+				ParticleRecord p{0, 0, 0, 0, 0, 0};
+				p.x = x(gen);
+				p.y = y(gen);
+				p.mass = mass(gen);
+				p.radius = rad(gen);
+				scene.particles.push_back(p);
+			}
+		}
+		copyParticles(records.particles.size());
+
+		if (chunk.error) {
+			try {
+				std::rethrow_exception(chunk.error);
+			}
+			catch (const std::exception&) {
+				std::throw_with_nested(std::runtime_error(
+					"Failed to load scene at line " +
+					std::to_string(lineCount + chunk.lineCount)));
+			}
+		}
+		if (chunk.ended) {
+			break;
+		}
+		lineCount += chunk.lineCount;
+	}
+	return scene;
+}
+
+}  // namespace
+
+SceneData parseScene(
+	const char* data, size_t size, uint32_t seed, unsigned threads) {
+	// Smaller chunks are not worth a thread
+	static const size_t MIN_CHUNK_BYTES = 1 << 18;
+
+	if (threads == 0) {
+		threads = std::thread::hardware_concurrency();
+	}
+	const size_t chunkCount = std::max<size_t>(
+		1, std::min<size_t>(threads, size / MIN_CHUNK_BYTES));
+
+	// Chunks start after a newline character, so no line is split
+	std::vector<const char*> bounds(chunkCount + 1, data + size);
+	bounds[0] = data;
+	for (size_t c = 1; c < chunkCount; c++) {
+		const char* start = std::max(bounds[c - 1], data + size * c / chunkCount);
+		const char* lineBreak = static_cast<const char*>(
+			std::memchr(start, '\n', data + size - start));
+		bounds[c] = lineBreak ? lineBreak + 1 : data + size;
+	}
+
+	std::vector<SceneChunk> chunks(chunkCount);
+	std::vector<std::future<void>> futures;
+	for (size_t c = 1; c < chunkCount; c++) {
+		futures.emplace_back(std::async(
+			std::launch::async, parseChunk, bounds[c], bounds[c + 1],
+			std::ref(chunks[c])));
+	}
+	parseChunk(bounds[0], bounds[1], chunks[0]);
+	for (auto& f : futures) {
+		f.get();
+	}
+	return mergeChunks(chunks, seed);
+}
+
+SceneData parseScene(std::istream& in, uint32_t seed) {
+	const std::string text(
+		(std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	return parseScene(text.data(), text.size(), seed);
+}
@@ -11,12 +11,6 @@ inline std::ostream& operator<<(std::ostream& out, const ShapeType& type) {
 	return out << getShapeTypeName(type);
 }
 
-inline bool operator<(
-	const std::reference_wrapper<BaseShape>& a,
-	const std::reference_wrapper<BaseShape>& b) {
-	return a.get().left < b.get().left;
-}
-
 Simulator::Simulator(
 	unsigned subStep, float restitutionCoeff, float frictionCoeff,
 	float nBodyGravity)
@@ -25,16 +19,77 @@ Simulator::Simulator(
 	  frictionCoeff(frictionCoeff),
 	  nBodyGravity(nBodyGravity) {}
 
+void Simulator::reserve(
+	size_t lineCount, size_t particleCount, size_t ballCount,
+	size_t boxCount) {
+	const size_t total = lineCount + particleCount + ballCount + boxCount;
+	baseShapes.reserve(baseShapes.size() + total);
+	baseShapeOwners.reserve(baseShapeOwners.size() + total);
+	reserveObjects(lines, lineCount);
+	reserveObjects(particles, particleCount);
+	reserveObjects(balls, ballCount);
+	reserveObjects(boxes, boxCount);
+}
+
 void Simulator::addForceField(const ForceField forceField) {
 	forceFields.emplace_back(forceField);
 }
 
-void Simulator::invalidateReferences() { areReferencesValid = false; }
+Handle<ParticleEmitter> Simulator::addEmitter(const ParticleEmitter& emitter) {
+	return emitters.emplace(emitter);
+}
+
+bool Simulator::removeEmitter(const Handle<ParticleEmitter>& handle) {
+	return emitters.erase(handle);
+}
+
+ParticleEmitter* Simulator::getEmitter(const Handle<ParticleEmitter>& handle) {
+	return emitters.get(handle);
+}
 
-const std::vector<Line>& Simulator::getLines() const { return lines; }
+const std::vector<ParticleEmitter>& Simulator::getEmitters() const {
+	return emitters.data();
+}
+
+void Simulator::setLifetime(const Handle<Particle>& particle, double seconds) {
+	expiries.push_back({particle, time + seconds});
+}
+
+double Simulator::getTime() const { return time; }
+
+void Simulator::emitParticles(float seconds) {
+	for (auto& emitter : emitters) {
+		emitter.emit(
+			seconds, [&](const Vector2D& pos, const Vector2D& vel, double mass,
+						 double radius, double lifetime) {
+				const auto handle = addParticle(pos, vel, mass, radius);
+				if (!std::isinf(lifetime)) {
+					setLifetime(handle, lifetime);
+				}
+				stats.spawned++;
+			});
+	}
+}
+
+void Simulator::removeExpiredParticles() {
+	// Predicate is applied exactly once per element
+	const auto last = std::remove_if(
+		expiries.begin(), expiries.end(), [this](const Expiry& expiry) {
+			if (expiry.time > time) {
+				return false;
+			}
+			stats.expired += remove(expiry.particle);
+			return true;
+		});
+	expiries.erase(last, expiries.end());
+}
+
+const std::vector<Line>& Simulator::getLines() const {
+	return lines.shapes.data();
+}
 
 const std::vector<Particle>& Simulator::getParticles() const {
-	return particles;
+	return particles.shapes.data();
 }
 
 const std::vector<std::reference_wrapper<BaseShape>>& Simulator::getBaseShapes()
@@ -42,147 +97,348 @@ const std::vector<std::reference_wrapper<BaseShape>>& Simulator::getBaseShapes()
 	return baseShapes;
 }
 
-const std::vector<Ball>& Simulator::getBalls() const { return balls; }
+const SimulationStats& Simulator::getStats() const { return stats; }
+
+void Simulator::setTraceRecorder(TraceRecorder* recorder) {
+	traceRecorder = recorder;
+}
+
+const std::vector<Ball>& Simulator::getBalls() const {
+	return balls.shapes.data();
+}
 
-const std::vector<Box>& Simulator::getBoxes() const { return boxes; }
+const std::vector<Box>& Simulator::getBoxes() const {
+	return boxes.shapes.data();
+}
 
-void Simulator::updateReferences() {
-	if (areReferencesValid) {
-		return;
+const std::vector<Chain>& Simulator::getChains() const {
+	return chains.shapes.data();
+}
+
+void Simulator::removeBaseShape(uint32_t position) {
+	baseShapes[position] = baseShapes.back();
+	baseShapeOwners[position] = baseShapeOwners.back();
+	auto& owner = baseShapeOwners[position];
+	(*owner.basePositions)[owner.slot] = position;
+	baseShapes.pop_back();
+	baseShapeOwners.pop_back();
+}
+
+namespace {
+
+// Corners of a box follow position corrections
+inline void updateCorners(BaseShape&) {}
+inline void updateCorners(Box& b) { b.updateCorners(); }
+
+}  // namespace
+
+/**
+ * Pushes shapes of manifold apart by its deepest point and queues it for the
+ * contact solver
+ */
+template <typename T1, typename T2>
+void Simulator::addContact(T1& first, T2& second, ContactManifold& manifold) {
+	SolverContact contact;
+	contact.first = contactBody(first);
+	contact.second = contactBody(second);
+	contact.manifold = &manifold;
+	const dataType invMassSum =
+		contact.first.invMass() + contact.second.invMass();
+	if (invMassSum == 0) return;
+
+	dataType deepest = 0;
+	for (int i = 0; i < manifold.pointCount; i++) {
+		deepest = std::min(deepest, manifold.points[i].separation);
+	}
+	const auto correction = std::max(-deepest - CONTACT_SLOP, 0.0f) /
+							invMassSum * manifold.normal;
+	if (contact.first.shape) {
+		contact.first.shape->pos -= correction * contact.first.invMass();
+	}
+	if (contact.second.shape) {
+		contact.second.shape->pos += correction * contact.second.invMass();
 	}
+	updateCorners(first);
+	updateCorners(second);
+	solverContacts.push_back(contact);
+}
 
-	dynamicShapes.clear();
-	baseShapes.clear();
-	dynamicShapes.reserve(balls.size() + particles.size() + boxes.size());
-	baseShapes.reserve(
-		balls.size() + particles.size() + boxes.size() + lines.size());
+template <> bool Simulator::manageCollision(Particle& p, Line& l, float) {
+	auto& manifold = getManifold(p, l);
+	if (!collideCircleLine(p.pos, p.rad, l, manifold)) {
+		return false;
+	}
+	addContact(p, l, manifold);
+	return true;
+}
 
-	for (auto& elem : balls) {
-		dynamicShapes.emplace_back(elem);
-		baseShapes.emplace_back(elem);
+template <> bool Simulator::manageCollision(Ball& b, Line& l, float) {
+	auto& manifold = getManifold(b, l);
+	if (!collideCircleLine(b.pos, b.rad, l, manifold)) {
+		return false;
 	}
+	addContact(b, l, manifold);
+	return true;
+}
 
-	for (auto& elem : particles) {
-		dynamicShapes.emplace_back(elem);
-		baseShapes.emplace_back(elem);
+template <>
+bool Simulator::manageCollision(
+	Particle& first, Particle& second, float seconds) {
+	// Same manifold whichever order the broadphase reports the pair in
+	if (manifoldKeyOf(second) < manifoldKeyOf(first)) {
+		return manageCollision(second, first, seconds);
+	}
+	auto& manifold = getManifold(first, second);
+	if (!collideCircles(
+			first.pos, first.rad, second.pos, second.rad, manifold)) {
+		return false;
 	}
+	addContact(first, second, manifold);
+	return true;
+}
 
-	for (auto& elem : boxes) {
-		dynamicShapes.emplace_back(elem);
-		baseShapes.emplace_back(elem);
+template <>
+bool Simulator::manageCollision(Ball& first, Particle& second, float) {
+	auto& manifold = getManifold(first, second);
+	if (!collideCircles(
+			first.pos, first.rad, second.pos, second.rad, manifold)) {
+		return false;
+	}
+	addContact(first, second, manifold);
+	return true;
+}
+
+template <>
+bool Simulator::manageCollision(Ball& first, Ball& second, float seconds) {
+	if (manifoldKeyOf(second) < manifoldKeyOf(first)) {
+		return manageCollision(second, first, seconds);
+	}
+	auto& manifold = getManifold(first, second);
+	if (!collideCircles(
+			first.pos, first.rad, second.pos, second.rad, manifold)) {
+		return false;
 	}
+	addContact(first, second, manifold);
+	return true;
+}
 
-	for (auto& elem : lines) {
-		baseShapes.emplace_back(elem);
+template <> bool Simulator::manageCollision(Box& b, Line& l, float) {
+	const Vector2D segment[] = {l.start, l.end};
+	auto& manifold = getManifold(b, l);
+	if (!collidePolygons(b.corner.data(), 4, segment, 2, manifold)) {
+		return false;
 	}
+	addContact(b, l, manifold);
+	return true;
+}
 
-	std::sort(baseShapes.begin(), baseShapes.end());
-	areReferencesValid = true;
+template <> bool Simulator::manageCollision(Box& b, Particle& p, float) {
+	auto& manifold = getManifold(b, p);
+	if (!collideBoxCircle(b, p.pos, p.rad, manifold)) {
+		return false;
+	}
+	addContact(b, p, manifold);
+	return true;
 }
 
-template <> bool Simulator::manageCollision(Ball& b, Line& l, float) {
-	float dist = distFromLine(l.start, l.end, b.pos);
-	if (dist <= b.rad * b.rad) {
-		dist = sqrt(dist) - b.rad;
-		if (dist < 0.0f) b.pos -= dist * l.normal;
-		if (b.vel.dot(l.normal) < 0.0) {
-			const auto normalComp = (b.vel * b.mass).projOnUnit(l.normal),
-					   normalImpulse = -(1 + restitutionCoeff) * normalComp;
-			const auto&& [tangentialCompMag, tangentialCompDir] =
-				(b.vel * b.mass - normalComp -
-				 b.angVel * b.inertia * b.rad * l.normal.rotate(1, 0))
-					.getMagnitudeAndDirection();
-			const auto frictionImpulse =
-				-frictionCoeff * std::min(normalComp.len(), tangentialCompMag) *
-				tangentialCompDir;
-			b.applyImpulse(
-				normalImpulse + frictionImpulse, b.pos - l.normal * b.rad);
-		}
-		// b.acc += -projOnUnit(b.acc, l.normal);
-		return true;
-	}
-	return false;
+template <> bool Simulator::manageCollision(Box& b, Ball& ball, float) {
+	auto& manifold = getManifold(b, ball);
+	if (!collideBoxCircle(b, ball.pos, ball.rad, manifold)) {
+		return false;
+	}
+	addContact(b, ball, manifold);
+	return true;
 }
 
 template <>
-bool Simulator::manageCollision(
-	Particle& first, Particle& second, float delTime) {
-	Vector2D n = second.pos - first.pos;
-	float dist = n.lenSq();
-	if (dist <= (first.rad + second.rad) * (first.rad + second.rad)) {
-		auto vRel = second.vel - first.vel;
-		dist = sqrt(dist);
-		n = n / dist;
-		dist -= first.rad + second.rad;
-		if (dist < 0.0f) {
-			first.vel += dist * n;
-			second.vel -= dist * n;
+bool Simulator::manageCollision(Box& first, Box& second, float seconds) {
+	if (manifoldKeyOf(second) < manifoldKeyOf(first)) {
+		return manageCollision(second, first, seconds);
+	}
+	auto& manifold = getManifold(first, second);
+	if (!collidePolygons(
+			first.corner.data(), 4, second.corner.data(), 4, manifold)) {
+		return false;
+	}
+	addContact(first, second, manifold);
+	return true;
+}
+
+template <> bool Simulator::manageCollision(Particle& p, Chain& c, float) {
+	bool touched = false;
+	c.querySegments(p, [&](uint32_t segment) {
+		auto& manifold = getManifold(p, c, segment);
+		if (collideCircleChain(p.pos, p.rad, c, segment, manifold)) {
+			addContact(p, c, manifold);
+			touched = true;
 		}
-		if (first.vel.dot(n) > second.vel.dot(n)) {
-			auto Impulse = (1 + restitutionCoeff) * vRel.projOnUnit(n) /
-						   (first.invMass + second.invMass);
-			first.vel += Impulse * first.invMass;
-			second.vel -= Impulse * second.invMass;
+	});
+	return touched;
+}
+
+template <> bool Simulator::manageCollision(Ball& b, Chain& c, float) {
+	bool touched = false;
+	c.querySegments(b, [&](uint32_t segment) {
+		auto& manifold = getManifold(b, c, segment);
+		if (collideCircleChain(b.pos, b.rad, c, segment, manifold)) {
+			addContact(b, c, manifold);
+			touched = true;
+		}
+	});
+	return touched;
+}
+
+template <> bool Simulator::manageCollision(Box& b, Chain& c, float) {
+	bool touched = false;
+	c.querySegments(b, [&](uint32_t segment) {
+		auto& manifold = getManifold(b, c, segment);
+		if (collidePolygonChain(b.corner.data(), 4, c, segment, manifold)) {
+			addContact(b, c, manifold);
+			touched = true;
+		}
+	});
+	return touched;
+}
+
+/**
+ * Sequential impulses over all contacts of the substep, warm started from
+ * impulses the manifolds kept from the last substep
+ */
+void Simulator::solveContacts() {
+	for (auto& contact : solverContacts) {
+		prepareContact(contact, restitutionCoeff);
+	}
+	for (auto& contact : solverContacts) {
+		warmStartContact(contact);
+	}
+	for (unsigned iteration = 0; iteration < solverIterations; iteration++) {
+		for (auto& contact : solverContacts) {
+			solveContact(contact, frictionCoeff);
+		}
+	}
+	for (const auto& contact : solverContacts) {
+		for (int i = 0; i < contact.manifold->pointCount; i++) {
+			stats.impulses += contact.manifold->points[i].normalImpulse > 0;
 		}
-		return true;
 	}
-	return false;
 }
 
-template <> bool Simulator::manageCollision(Box& b, Line& l, float) {
-	float dist = distFromLine(l.start, l.end, b.pos);
-	if (dist <= b.w * b.h) {
-		dist = sqrt(dist) - sqrt(b.w * b.h);
-		if (dist < 0.0f) b.pos -= dist * l.normal;
-		if (b.vel.dot(l.normal) < 0.0)
-			b.applyImpulse(
-				-(1 + restitutionCoeff) * b.mass * b.vel.projOnUnit(l.normal),
-				b.pos + 0.5 * sqrt(b.w * b.h) *
-							Vector2D(std::cos(b.angle), std::sin(b.angle)));
-		// commands
-		// b.acc += -projOnUnit(b.acc, l.normal);
-		return true;
-	}
-	return false;
-}
-
-template <> bool Simulator::manageCollision(Particle& b, Line& l, float) {
-	float dist = distFromLine(l.start, l.end, b.pos);
-	if (dist <= b.rad * b.rad) {
-		dist = sqrt(dist) - b.rad;
-		if (dist < 0.0f) b.pos -= dist * l.normal;
-		if (b.vel.dot(l.normal) < 0.0) {
-			const auto normalComp = b.vel.projOnUnit(l.normal),
-					   normalImpulse = -(1 + restitutionCoeff) * normalComp;
-			const auto [tangentialCompMag, tangentialCompDir] =
-				(b.vel - normalComp).getMagnitudeAndDirection();
-			const auto frictionImpulse =
-				-frictionCoeff * std::min(normalComp.len(), tangentialCompMag) *
-				tangentialCompDir;
-			b.applyImpulse(normalImpulse + frictionImpulse, b.pos);
-		}
-		// b.acc += -projOnUnit(b.acc, l.normal);
-		return true;
-	}
-	return false;
+template <typename T, bool Swapped>
+void Simulator::manageCircleLineCollisions(
+	const CollisionPair* begin, const CollisionPair* end, float seconds) {
+	const size_t count = end - begin;
+	CircleLinePairs candidates(count, &frameArena);
+	for (size_t i = 0; i < count; i++) {
+		auto& first = baseShapes[begin[i].first].get();
+		auto& second = baseShapes[begin[i].second].get();
+		const auto& circle = static_cast<const T&>(Swapped ? second : first);
+		candidates.set(
+			i, circle.pos, circle.rad,
+			static_cast<const Line&>(Swapped ? first : second));
+	}
+	std::pmr::vector<uint32_t> touching(count, &frameArena);
+	touching.resize(findTouchingPairs(candidates, touching.data()));
+
+	// Contacts added earlier in the batch move circles, a pair whose circle
+	// is no longer where it was packed is tested again even if it was
+	// rejected, so pairs are handled as if each was tested in turn
+	size_t contacts = 0, nextTouching = 0;
+	for (size_t i = 0; i < count; i++) {
+		const bool isTouching =
+			nextTouching < touching.size() && touching[nextTouching] == i;
+		nextTouching += isTouching;
+		auto& first = baseShapes[begin[i].first].get();
+		auto& second = baseShapes[begin[i].second].get();
+		auto& circle = static_cast<T&>(Swapped ? second : first);
+		auto& line = static_cast<Line&>(Swapped ? first : second);
+		if (!isTouching && circle.pos.x == candidates.centerX[i] &&
+			circle.pos.y == candidates.centerY[i]) {
+			// Separated pair keeps no points, so a later touch in this step
+			// is not warm started with impulses of an earlier one
+			const auto manifold = manifolds.find(
+				{manifoldKeyOf(circle), manifoldKeyOf(line), 0});
+			if (manifold != manifolds.end()) {
+				manifold->second.points = {};
+				manifold->second.pointCount = 0;
+			}
+			continue;
+		}
+		contacts += manageCollision(circle, line, seconds);
+	}
+	stats.contacts += contacts;
+}
+
+void Simulator::manageCollisions(
+	const std::pmr::vector<CollisionPair>& pairs, float seconds) {
+	static constexpr auto batches = makeCollisionBatches(
+		std::make_index_sequence<SHAPE_ID_COUNT * SHAPE_ID_COUNT>());
+
+	// Counting sort of pairs by the ids of their types, lower id first, so
+	// each batch is handled without branching on types per pair
+	std::array<size_t, SHAPE_ID_COUNT * SHAPE_ID_COUNT + 1> starts{};
+	std::pmr::vector<uint8_t> keys(pairs.size(), &frameArena);
+	for (size_t i = 0; i < pairs.size(); i++) {
+		const uint8_t first = baseShapeOwners[pairs[i].first].shapeId,
+					  second = baseShapeOwners[pairs[i].second].shapeId;
+		keys[i] = std::min(first, second) * SHAPE_ID_COUNT +
+				  std::max(first, second);
+		starts[keys[i] + 1]++;
+	}
+	for (size_t key = 0; key < SHAPE_ID_COUNT * SHAPE_ID_COUNT; key++) {
+		starts[key + 1] += starts[key];
+	}
+	std::pmr::vector<CollisionPair> sorted(pairs.size(), &frameArena);
+	auto next = starts;
+	for (size_t i = 0; i < pairs.size(); i++) {
+		auto pair = pairs[i];
+		if (baseShapeOwners[pair.first].shapeId >
+			baseShapeOwners[pair.second].shapeId) {
+			std::swap(pair.first, pair.second);
+		}
+		sorted[next[keys[i]]++] = pair;
+	}
+
+	for (size_t key = 0; key < SHAPE_ID_COUNT * SHAPE_ID_COUNT; key++) {
+		if (batches[key] != nullptr && starts[key] != starts[key + 1]) {
+			(this->*batches[key])(
+				sorted.data() + starts[key], sorted.data() + starts[key + 1],
+				seconds);
+		}
+	}
 }
 
 void Simulator::simulate(float seconds) {
-	updateReferences();
+	ScopedTrace simulateTrace(traceRecorder, "Simulate");
+	stats.reset(subStep);
+	contactStep++;
+	if (!emitters.empty()) {
+		PHASE_TIMER(stats, traceRecorder, 0, EMITTERS);
+		emitParticles(seconds);
+	}
 	const float delta = seconds / subStep;
 	for (unsigned step = 0; step < subStep; ++step) {
-		for (auto& objRef : dynamicShapes) {
-			auto& obj = objRef.get();
-			obj.move(delta);
-			for (const auto& forceField : forceFields) {
-				obj.applyImpulse(forceField.getForce(obj) * delta, obj.pos);
-			}
+		ScopedTrace subStepTrace(traceRecorder, "Substep");
+		frameArena.reset();
+		{
+			PHASE_TIMER(stats, traceRecorder, step, INTEGRATION);
+			forEachDynamicShape([delta](auto& obj) { obj.move(delta); });
+		}
+		if (!forceFields.empty()) {
+			PHASE_TIMER(stats, traceRecorder, step, FORCE_FIELDS);
+			forEachDynamicShape([&](auto& obj) {
+				for (const auto& forceField : forceFields) {
+					obj.applyImpulse(forceField.getForce(obj) * delta, obj.pos);
+				}
+			});
 		}
 		if (nBodyGravity > 0) {
-			for (size_t i = 0; i < dynamicShapes.size(); i++) {
-				auto& a = dynamicShapes[i].get();
-				for (size_t j = i + 1; j < dynamicShapes.size(); j++) {
-					auto& b = dynamicShapes[j].get();
+			PHASE_TIMER(stats, traceRecorder, step, N_BODY);
+			std::pmr::vector<DynamicShape*> bodies(&frameArena);
+			forEachDynamicShape([&](auto& obj) { bodies.push_back(&obj); });
+			for (size_t i = 0; i < bodies.size(); i++) {
+				auto& a = *bodies[i];
+				for (size_t j = i + 1; j < bodies.size(); j++) {
+					auto& b = *bodies[j];
 					auto const [mag, dir] =
 						(b.pos - a.pos).getMagnitudeAndDirection();
 					auto impulse =
@@ -193,39 +449,52 @@ void Simulator::simulate(float seconds) {
 			}
 		}
 
-		const auto possibleCollisions = getCollisionBruteForceSAT(baseShapes);
-
-		for (auto& p : possibleCollisions) {
-			auto &firstObj = baseShapes[p.first].get(),
-				 &secondObj = baseShapes[p.second].get();
-			ShapeType firstType = firstObj.getClass(),
-					  secondType = secondObj.getClass();
+		CollisionPairs possibleCollisions(&frameArena);
+		{
+			PHASE_TIMER(stats, traceRecorder, step, BROADPHASE);
+			possibleCollisions =
+				getCollisionBruteForceSAT(baseShapes, &frameArena);
+		}
+		stats.candidatePairs += possibleCollisions.size();
 
-			if (firstType == LINE && secondType == PARTICLE) {
-				manageCollision(
-					static_cast<Particle&>(secondObj),
-					static_cast<Line&>(firstObj), seconds);
-			}
-			else if (firstType == PARTICLE && secondType == LINE) {
-				manageCollision(
-					static_cast<Particle&>(firstObj),
-					static_cast<Line&>(secondObj), seconds);
-			}
-			else if (firstType == PARTICLE && secondType == PARTICLE) {
-				manageCollision(
-					static_cast<Particle&>(firstObj),
-					static_cast<Particle&>(secondObj), seconds);
-			}
+		solverContacts.clear();
+		{
+			PHASE_TIMER(stats, traceRecorder, step, NARROWPHASE);
+			manageCollisions(possibleCollisions, seconds);
+		}
+		if (!solverContacts.empty()) {
+			PHASE_TIMER(stats, traceRecorder, step, SOLVER);
+			solveContacts();
+		}
+		stats.frameBytes = std::max(stats.frameBytes, frameArena.bytesUsed());
+	}
+	time += seconds;
+	// Manifolds of pairs whose bounding boxes stopped overlapping
+	for (auto it = manifolds.begin(); it != manifolds.end();) {
+		if (it->second.lastStep != contactStep) {
+			it = manifolds.erase(it);
+		}
+		else {
+			++it;
 		}
 	}
+	if (!expiries.empty()) {
+		PHASE_TIMER(stats, traceRecorder, subStep - 1, EMITTERS);
+		removeExpiredParticles();
+	}
 }
 
 void Simulator::clear() {
+	time = 0;
 	forceFields.clear();
-	balls.clear();
-	boxes.clear();
-	particles.clear();
-	lines.clear();
-	dynamicShapes.clear();
+	emitters.clear();
+	expiries.clear();
+	manifolds.clear();
+	balls.shapes.clear();
+	boxes.shapes.clear();
+	particles.shapes.clear();
+	lines.shapes.clear();
+	chains.shapes.clear();
 	baseShapes.clear();
+	baseShapeOwners.clear();
 }
@@ -0,0 +1,219 @@
+#include <PhysicsEngine2D/Simulator.hpp>
+#include <PhysicsEngine2D/StatePublisher.hpp>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Arrays start on cache lines, so capacity is rounded up to 16 floats
+static size_t roundCapacity(size_t capacity) {
+	return (std::max<size_t>(capacity, 1) + 15) / 16 * 16;
+}
+
+static size_t arrayOffset(SharedStateArray array, size_t capacity) {
+	return sizeof(SharedFrameHeader) + array * capacity * sizeof(float);
+}
+
+static size_t frameBytes(size_t capacity) {
+	return arrayOffset(SHARED_IDS, capacity) + capacity * sizeof(uint64_t);
+}
+
+static size_t headerBytes() {
+	return (sizeof(SharedStateHeader) + 63) / 64 * 64;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+StatePublisher::StatePublisher(
+	const std::string& name, const StatePublisherOptions& options)
+	: name(name) {
+	const size_t capacity = roundCapacity(options.capacity);
+	if (capacity > std::numeric_limits<uint32_t>::max()) {
+		throw std::runtime_error("Capacity of shared state is too large");
+	}
+	const unsigned frames = std::max(1u, options.frames);
+	length = headerBytes() + frames * frameBytes(capacity);
+
+	// Fresh object, readers of a stale one keep their own mapping
+	shm_unlink(name.c_str());
+	const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0) {
+		throw std::runtime_error("Unable to create shared memory " + name);
+	}
+	if (ftruncate(fd, length) != 0) {
+		close(fd);
+		shm_unlink(name.c_str());
+		throw std::runtime_error("Unable to size shared memory " + name);
+	}
+	void* mapped =
+		mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		shm_unlink(name.c_str());
+		throw std::runtime_error("Unable to map shared memory " + name);
+	}
+	address = static_cast<char*>(mapped);
+
+	// Object is zero filled, so sequences and counts start at zero
+	header = new (address) SharedStateHeader;
+	std::memcpy(header->magic, SHARED_STATE_MAGIC, sizeof(SHARED_STATE_MAGIC));
+	header->version = SHARED_STATE_VERSION;
+	header->frameCount = frames;
+	header->capacity = capacity;
+	header->frameBytes = frameBytes(capacity);
+	for (unsigned i = 0; i < frames; i++) {
+		new (address + headerBytes() + i * header->frameBytes)
+			SharedFrameHeader;
+	}
+	header->published.store(0, std::memory_order_release);
+}
+
+StatePublisher::~StatePublisher() {
+	munmap(address, length);
+	shm_unlink(name.c_str());
+}
+
+SharedStateReader::SharedStateReader(const std::string& name) {
+	const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0) {
+		throw std::runtime_error("Unable to open shared memory " + name);
+	}
+	struct stat status;
+	if (fstat(fd, &status) != 0) {
+		close(fd);
+		throw std::runtime_error("Unable to stat shared memory " + name);
+	}
+	length = status.st_size;
+	if (length < headerBytes()) {
+		close(fd);
+		throw std::invalid_argument(name + " is not published state");
+	}
+	void* mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		throw std::runtime_error("Unable to map shared memory " + name);
+	}
+	address = static_cast<char*>(mapped);
+	header = reinterpret_cast<const SharedStateHeader*>(address);
+
+	if (std::memcmp(
+			header->magic, SHARED_STATE_MAGIC, sizeof(SHARED_STATE_MAGIC)) !=
+			0 ||
+		header->version != SHARED_STATE_VERSION || header->frameCount == 0 ||
+		header->frameBytes != frameBytes(header->capacity) ||
+		headerBytes() + header->frameCount * header->frameBytes > length) {
+		munmap(address, length);
+		throw std::invalid_argument(name + " is not published state");
+	}
+}
+
+SharedStateReader::~SharedStateReader() { munmap(address, length); }
+
+#else
+
+StatePublisher::StatePublisher(
+	const std::string& name, const StatePublisherOptions&) {
+	throw std::runtime_error("Shared memory is not supported for " + name);
+}
+
+StatePublisher::~StatePublisher() {}
+
+SharedStateReader::SharedStateReader(const std::string& name) {
+	throw std::runtime_error("Shared memory is not supported for " + name);
+}
+
+SharedStateReader::~SharedStateReader() {}
+
+#endif
+
+bool StatePublisher::publish(const Simulator& sim) {
+	const auto& particles = sim.getParticles();
+	const auto& balls = sim.getBalls();
+	const auto& boxes = sim.getBoxes();
+	const size_t count = particles.size() + balls.size() + boxes.size();
+	const uint64_t step = steps++;
+	if (count > header->capacity) {
+		return false;
+	}
+
+	const uint64_t published = header->published.load(std::memory_order_relaxed);
+	char* base = address + headerBytes() +
+				 published % header->frameCount * header->frameBytes;
+	auto frame = reinterpret_cast<SharedFrameHeader*>(base);
+	const uint64_t sequence = frame->sequence.load(std::memory_order_relaxed);
+	frame->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	frame->step = step;
+	frame->time = sim.getTime();
+	frame->particles = particles.size();
+	frame->balls = balls.size();
+	frame->boxes = boxes.size();
+	auto posX = reinterpret_cast<float*>(
+		base + arrayOffset(SHARED_POS_X, header->capacity));
+	auto posY = reinterpret_cast<float*>(
+		base + arrayOffset(SHARED_POS_Y, header->capacity));
+	auto velX = reinterpret_cast<float*>(
+		base + arrayOffset(SHARED_VEL_X, header->capacity));
+	auto velY = reinterpret_cast<float*>(
+		base + arrayOffset(SHARED_VEL_Y, header->capacity));
+	auto ids = reinterpret_cast<uint64_t*>(
+		base + arrayOffset(SHARED_IDS, header->capacity));
+	size_t i = 0;
+	auto write = [&](const auto& shapes) {
+		using Shape = typename std::decay_t<decltype(shapes)>::value_type;
+		for (size_t j = 0; j < shapes.size(); j++, i++) {
+			posX[i] = shapes[j].pos.x;
+			posY[i] = shapes[j].pos.y;
+			velX[i] = shapes[j].vel.x;
+			velY[i] = shapes[j].vel.y;
+			ids[i] = sharedStateId(sim.getHandle<Shape>(j));
+		}
+	};
+	write(particles);
+	write(balls);
+	write(boxes);
+
+	frame->sequence.store(sequence + 2, std::memory_order_release);
+	header->published.store(published + 1, std::memory_order_release);
+	return true;
+}
+
+const SharedFrameHeader* SharedStateReader::frameAt(uint64_t index) const {
+	return reinterpret_cast<const SharedFrameHeader*>(
+		address + headerBytes() +
+		index % header->frameCount * header->frameBytes);
+}
+
+SharedStateView SharedStateReader::viewOf(
+	const SharedFrameHeader* frame) const {
+	const char* base = reinterpret_cast<const char*>(frame);
+	SharedStateView view;
+	view.step = frame->step;
+	view.time = frame->time;
+	// Counts are clamped, a torn read must not run past the arrays
+	view.particles = std::min(frame->particles, header->capacity);
+	view.balls = std::min(frame->balls, header->capacity - view.particles);
+	view.boxes =
+		std::min(frame->boxes, header->capacity - view.particles - view.balls);
+	view.posX = reinterpret_cast<const float*>(
+		base + arrayOffset(SHARED_POS_X, header->capacity));
+	view.posY = reinterpret_cast<const float*>(
+		base + arrayOffset(SHARED_POS_Y, header->capacity));
+	view.velX = reinterpret_cast<const float*>(
+		base + arrayOffset(SHARED_VEL_X, header->capacity));
+	view.velY = reinterpret_cast<const float*>(
+		base + arrayOffset(SHARED_VEL_Y, header->capacity));
+	view.ids = reinterpret_cast<const uint64_t*>(
+		base + arrayOffset(SHARED_IDS, header->capacity));
+	return view;
+}
@@ -0,0 +1,94 @@
+#include <PhysicsEngine2D/TraceRecorder.hpp>
+#include <algorithm>
+
+static std::atomic<uint64_t> nextRecorderId{1};
+
+static size_t roundUpToPowerOf2(size_t n) {
+	size_t power = 1;
+	while (power < n) power <<= 1;
+	return power;
+}
+
+TraceRecorder::TraceRecorder(size_t eventsPerThread)
+	: id(nextRecorderId++),
+	  capacity(roundUpToPowerOf2(std::max<size_t>(eventsPerThread, 2))),
+	  startTime(Clock::now()) {}
+
+TraceBuffer& TraceRecorder::getThreadBuffer() {
+	// Cache of the last recorder used by this thread
+	thread_local uint64_t cachedId = 0;
+	thread_local TraceBuffer* cachedBuffer = nullptr;
+	if (cachedId == id) {
+		return *cachedBuffer;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto threadId = std::this_thread::get_id();
+	cachedBuffer = nullptr;
+	for (auto& buffer : buffers) {
+		if (buffer->owner == threadId) {
+			cachedBuffer = buffer.get();
+		}
+	}
+	if (cachedBuffer == nullptr) {
+		buffers.emplace_back(
+			std::make_unique<TraceBuffer>(capacity, buffers.size() + 1));
+		cachedBuffer = buffers.back().get();
+	}
+	cachedId = id;
+	return *cachedBuffer;
+}
+
+void TraceRecorder::record(
+	const char* name, char phase, Clock::time_point time) {
+	getThreadBuffer().push(
+		{name,
+		 std::chrono::duration_cast<std::chrono::nanoseconds>(time - startTime)
+			 .count(),
+		 phase});
+}
+
+static void writeJsonString(std::ostream& out, const char* str) {
+	out << '"';
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\') out << '\\';
+		out << *str;
+	}
+	out << '"';
+}
+
+void TraceRecorder::writeChromeTrace(std::ostream& out) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	for (auto& buffer : buffers) {
+		// Ring may have overwritten begin events of the oldest end events
+		int depth = 0;
+		buffer->forEach([&](const TraceEvent& event) {
+			if (event.phase == 'E') {
+				if (depth == 0) return;
+				depth--;
+			}
+			else {
+				depth++;
+			}
+			if (!first) out << ",";
+			first = false;
+			out << "\n{\"name\":";
+			writeJsonString(out, event.name);
+			out << ",\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":"
+				<< buffer->threadIndex << ",\"ts\":" << event.nanoseconds / 1000
+				<< "." << event.nanoseconds / 100 % 10
+				<< event.nanoseconds / 10 % 10 << event.nanoseconds % 10
+				<< "}";
+		});
+	}
+	out << "\n]}\n";
+}
+
+void TraceRecorder::clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto& buffer : buffers) {
+		buffer->clear();
+	}
+}
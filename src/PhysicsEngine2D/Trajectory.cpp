@@ -0,0 +1,287 @@
+#include <PhysicsEngine2D/Simulator.hpp>
+#include <PhysicsEngine2D/Trajectory.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+void TrajectoryFrame::capture(const Simulator& sim, uint64_t step) {
+	this->step = step;
+	time = sim.getTime();
+	const auto& particleShapes = sim.getParticles();
+	const auto& ballShapes = sim.getBalls();
+	const auto& boxShapes = sim.getBoxes();
+	particles = particleShapes.size();
+	balls = ballShapes.size();
+	boxes = boxShapes.size();
+	for (auto& field : fields) {
+		field.resize(particles + balls + boxes);
+	}
+
+	size_t i = 0;
+	auto setMotion = [&](const DynamicShape& shape, double angle) {
+		fields[POS_X][i] = shape.pos.x;
+		fields[POS_Y][i] = shape.pos.y;
+		fields[VEL_X][i] = shape.vel.x;
+		fields[VEL_Y][i] = shape.vel.y;
+		fields[ANGLE][i] = angle;
+	};
+	for (const auto& particle : particleShapes) {
+		setMotion(particle, 0);
+		fields[SIZE_X][i] = fields[SIZE_Y][i] = particle.rad;
+		i++;
+	}
+	for (const auto& ball : ballShapes) {
+		setMotion(ball, ball.angle);
+		fields[SIZE_X][i] = fields[SIZE_Y][i] = ball.rad;
+		i++;
+	}
+	for (const auto& box : boxShapes) {
+		setMotion(box, box.angle);
+		fields[SIZE_X][i] = box.w;
+		fields[SIZE_Y][i] = box.h;
+		i++;
+	}
+}
+
+double TrajectoryQuanta::of(TrajectoryField field) const {
+	switch (field) {
+		case VEL_X:
+		case VEL_Y:
+			return velocity;
+		case ANGLE:
+			return angle;
+		default:
+			return position;
+	}
+}
+
+namespace {
+
+// Magnitude beyond which quantized values are clamped, exact in a double
+const double MAX_QUANTIZED = 9007199254740992.0;
+
+// Flags of an encoded frame
+const uint8_t DELTA_FRAME = 1;
+
+inline int64_t quantize(float value, double quantum) {
+	if (!std::isfinite(value)) {
+		return 0;
+	}
+	return std::llround(
+		std::clamp(value / quantum, -MAX_QUANTIZED, MAX_QUANTIZED));
+}
+
+inline void writeVarint(uint64_t value, std::vector<uint8_t>& out) {
+	while (value >= 0x80) {
+		out.push_back(uint8_t(value) | 0x80);
+		value >>= 7;
+	}
+	out.push_back(uint8_t(value));
+}
+
+inline uint64_t zigzag(int64_t value) {
+	return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value) {
+	return int64_t(value >> 1) ^ -int64_t(value & 1);
+}
+
+inline uint64_t readVarint(const uint8_t*& data, const uint8_t* end) {
+	uint64_t value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (data == end) {
+			throw std::invalid_argument("Truncated trajectory frame");
+		}
+		const uint8_t byte = *data++;
+		value |= uint64_t(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			return value;
+		}
+	}
+	throw std::invalid_argument("Corrupt trajectory frame");
+}
+
+}  // namespace
+
+void TrajectoryEncoder::encode(
+	const TrajectoryFrame& frame, std::vector<uint8_t>& out) {
+	const bool delta = hasPrevious && frame.particles == particles &&
+					   frame.balls == balls && frame.boxes == boxes;
+	writeVarint(frame.step, out);
+	const size_t timeAt = out.size();
+	out.resize(timeAt + sizeof(frame.time));
+	std::memcpy(out.data() + timeAt, &frame.time, sizeof(frame.time));
+	out.push_back(delta ? DELTA_FRAME : 0);
+	writeVarint(frame.particles, out);
+	writeVarint(frame.balls, out);
+	writeVarint(frame.boxes, out);
+
+	// Same field of all bodies is stored together, consecutive deltas of
+	// slowly changing fields are then mostly single bytes
+	for (int f = 0; f < TRAJECTORY_FIELD_COUNT; f++) {
+		const double quantum = quanta.of(TrajectoryField(f));
+		const auto& values = frame.fields[f];
+		auto& last = previous[f];
+		last.resize(values.size(), 0);
+		for (size_t i = 0; i < values.size(); i++) {
+			const int64_t quantized = quantize(values[i], quantum);
+			writeVarint(zigzag(delta ? quantized - last[i] : quantized), out);
+			last[i] = quantized;
+		}
+	}
+	particles = frame.particles;
+	balls = frame.balls;
+	boxes = frame.boxes;
+	hasPrevious = true;
+}
+
+const uint8_t* TrajectoryDecoder::decode(
+	const uint8_t* data, const uint8_t* end, TrajectoryFrame& frame) {
+	frame.step = readVarint(data, end);
+	if (size_t(end - data) < sizeof(frame.time) + 1) {
+		throw std::invalid_argument("Truncated trajectory frame");
+	}
+	std::memcpy(&frame.time, data, sizeof(frame.time));
+	data += sizeof(frame.time);
+	const bool delta = *data++ & DELTA_FRAME;
+	frame.particles = readVarint(data, end);
+	frame.balls = readVarint(data, end);
+	frame.boxes = readVarint(data, end);
+
+	const size_t count = size_t(frame.particles) + frame.balls + frame.boxes;
+	// Each value takes at least a byte
+	if (count * TRAJECTORY_FIELD_COUNT > size_t(end - data)) {
+		throw std::invalid_argument("Truncated trajectory frame");
+	}
+	if (delta && previous[0].size() != count) {
+		throw std::invalid_argument(
+			"Trajectory frame refers to a missing previous frame");
+	}
+	for (int f = 0; f < TRAJECTORY_FIELD_COUNT; f++) {
+		const double quantum = quanta.of(TrajectoryField(f));
+		auto& values = frame.fields[f];
+		auto& last = previous[f];
+		values.resize(count);
+		last.resize(count, 0);
+		for (size_t i = 0; i < count; i++) {
+			const int64_t value = unzigzag(readVarint(data, end));
+			last[i] = delta ? last[i] + value : value;
+			values[i] = last[i] * quantum;
+		}
+	}
+	return data;
+}
+
+TrajectoryReader::TrajectoryReader(const std::filesystem::path& filePath)
+	: file(filePath) {
+	if (file.size() < sizeof(header) ||
+		std::memcmp(
+			file.data(), TRAJECTORY_FILE_MAGIC,
+			sizeof(TRAJECTORY_FILE_MAGIC)) != 0) {
+		throw std::invalid_argument(
+			"Not a trajectory file " + filePath.string());
+	}
+	std::memcpy(&header, file.data(), sizeof(header));
+	if (header.byteOrder != TRAJECTORY_FILE_BYTE_ORDER) {
+		throw std::invalid_argument(
+			"Trajectory was written with a different byte order");
+	}
+	if (header.version != TRAJECTORY_FILE_VERSION) {
+		throw std::invalid_argument(
+			"Unsupported trajectory version " + std::to_string(header.version));
+	}
+	decoder = TrajectoryDecoder(getQuanta());
+
+	TrajectoryFileFooter footer;
+	bool indexed = false;
+	if (file.size() >= sizeof(header) + sizeof(footer)) {
+		std::memcpy(
+			&footer, file.data() + file.size() - sizeof(footer),
+			sizeof(footer));
+		indexed = std::memcmp(
+					  footer.magic, TRAJECTORY_INDEX_MAGIC,
+					  sizeof(TRAJECTORY_INDEX_MAGIC)) == 0 &&
+				  footer.indexOffset <= file.size() - sizeof(footer) &&
+				  footer.chunkCount ==
+					  (file.size() - sizeof(footer) - footer.indexOffset) /
+						  sizeof(TrajectoryIndexEntry);
+	}
+	if (indexed) {
+		index.resize(footer.chunkCount);
+		std::memcpy(
+			index.data(), file.data() + footer.indexOffset,
+			index.size() * sizeof(TrajectoryIndexEntry));
+	}
+	else {
+		scanChunks();
+	}
+
+	chunkStarts.assign(1, 0);
+	for (const auto& entry : index) {
+		chunkStarts.push_back(chunkStarts.back() + entry.frameCount);
+	}
+}
+
+void TrajectoryReader::scanChunks() {
+	// Last chunk of an interrupted run may be incomplete and is ignored
+	uint64_t offset = sizeof(header);
+	TrajectoryChunkHeader chunk;
+	while (file.size() - offset >= sizeof(chunk)) {
+		std::memcpy(&chunk, file.data() + offset, sizeof(chunk));
+		if (std::memcmp(
+				chunk.magic, TRAJECTORY_CHUNK_MAGIC,
+				sizeof(TRAJECTORY_CHUNK_MAGIC)) != 0 ||
+			chunk.bytes > file.size() - offset - sizeof(chunk)) {
+			break;
+		}
+		index.push_back({offset, chunk.firstStep, chunk.frameCount, 0});
+		offset += sizeof(chunk) + chunk.bytes;
+	}
+}
+
+TrajectoryQuanta TrajectoryReader::getQuanta() const {
+	TrajectoryQuanta quanta;
+	quanta.position = header.positionQuantum;
+	quanta.velocity = header.velocityQuantum;
+	quanta.angle = header.angleQuantum;
+	return quanta;
+}
+
+void TrajectoryReader::readFrame(size_t frameIndex, TrajectoryFrame& frame) {
+	if (frameIndex >= getFrameCount()) {
+		throw std::out_of_range(
+			"Trajectory has no frame " + std::to_string(frameIndex));
+	}
+	const size_t c =
+		std::upper_bound(chunkStarts.begin(), chunkStarts.end(), frameIndex) -
+		chunkStarts.begin() - 1;
+	TrajectoryChunkHeader chunk;
+	if (index[c].offset > file.size() ||
+		file.size() - index[c].offset < sizeof(chunk)) {
+		throw std::invalid_argument("Trajectory index out of bounds");
+	}
+	const char* chunkData = file.data() + index[c].offset;
+	std::memcpy(&chunk, chunkData, sizeof(chunk));
+	if (chunk.bytes > file.size() - index[c].offset - sizeof(chunk)) {
+		throw std::invalid_argument("Trajectory chunk out of bounds");
+	}
+	const auto* begin =
+		reinterpret_cast<const uint8_t*>(chunkData + sizeof(chunk));
+	const auto* end = begin + chunk.bytes;
+
+	// Frames after the first of a chunk are deltas, so decoding starts at the
+	// chunk unless the previous frame was just decoded
+	const uint8_t* data = nextData;
+	nextData = nullptr;
+	if (frameIndex != nextFrame || frameIndex == chunkStarts[c] ||
+		data == nullptr) {
+		data = begin;
+		for (size_t i = chunkStarts[c]; i < frameIndex; i++) {
+			data = decoder.decode(data, end, frame);
+		}
+	}
+	nextData = decoder.decode(data, end, frame);
+	nextFrame = frameIndex + 1;
+}
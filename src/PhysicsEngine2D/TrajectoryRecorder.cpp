@@ -0,0 +1,149 @@
+#include <PhysicsEngine2D/TrajectoryRecorder.hpp>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+TrajectoryRecorder::TrajectoryRecorder(
+	const std::filesystem::path& filePath, const TrajectoryOptions& options)
+	: options(options), file(filePath, std::ios::binary | std::ios::trunc) {
+	if (!file) {
+		throw std::runtime_error("Unable to create " + filePath.string());
+	}
+	this->options.stride = std::max(1u, options.stride);
+	this->options.framesPerChunk = std::max(1u, options.framesPerChunk);
+
+	TrajectoryFileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(
+		header.magic, TRAJECTORY_FILE_MAGIC, sizeof(TRAJECTORY_FILE_MAGIC));
+	header.version = TRAJECTORY_FILE_VERSION;
+	header.byteOrder = TRAJECTORY_FILE_BYTE_ORDER;
+	header.stride = this->options.stride;
+	header.positionQuantum = options.quanta.position;
+	header.velocityQuantum = options.quanta.velocity;
+	header.angleQuantum = options.quanta.angle;
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	writer = std::thread(&TrajectoryRecorder::writeFrames, this);
+}
+
+TrajectoryRecorder::~TrajectoryRecorder() {
+	try {
+		close();
+	}
+	catch (...) {
+	}
+}
+
+void TrajectoryRecorder::record(const Simulator& sim) {
+	if (steps++ % options.stride != 0) {
+		return;
+	}
+	captured.capture(sim, steps - 1);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (hasPending || closing) {
+			droppedFrames++;
+			return;
+		}
+		// Swapping keeps capacity of both frames, so steady state does not
+		// allocate
+		std::swap(captured, pending);
+		hasPending = true;
+	}
+	frameReady.notify_one();
+}
+
+void TrajectoryRecorder::close() {
+	if (!writer.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closing = true;
+	}
+	frameReady.notify_one();
+	writer.join();
+	file.close();
+	if (writeError) {
+		std::rethrow_exception(writeError);
+	}
+}
+
+void TrajectoryRecorder::writeFrames() {
+	try {
+		TrajectoryEncoder encoder(options.quanta);
+		TrajectoryFrame frame;
+		std::vector<uint8_t> chunk;
+		std::vector<TrajectoryIndexEntry> index;
+		uint64_t offset = sizeof(TrajectoryFileHeader), frameCount = 0;
+		TrajectoryChunkHeader chunkHeader;
+		std::memcpy(
+			chunkHeader.magic, TRAJECTORY_CHUNK_MAGIC,
+			sizeof(TRAJECTORY_CHUNK_MAGIC));
+		chunkHeader.frameCount = 0;
+
+		auto writeChunk = [&]() {
+			chunkHeader.bytes = chunk.size();
+			file.write(
+				reinterpret_cast<const char*>(&chunkHeader),
+				sizeof(chunkHeader));
+			file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+			if (!file) {
+				throw std::runtime_error("Failed to write trajectory");
+			}
+			index.push_back(
+				{offset, chunkHeader.firstStep, chunkHeader.frameCount, 0});
+			offset += sizeof(chunkHeader) + chunk.size();
+			chunk.clear();
+			chunkHeader.frameCount = 0;
+			encoder.reset();
+		};
+
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				frameReady.wait(lock, [this] { return hasPending || closing; });
+				if (!hasPending) {
+					break;
+				}
+				std::swap(frame, pending);
+				hasPending = false;
+			}
+			if (chunkHeader.frameCount == 0) {
+				chunkHeader.firstStep = frame.step;
+			}
+			encoder.encode(frame, chunk);
+			chunkHeader.frameCount++;
+			frameCount++;
+			recordedFrames++;
+			if (chunkHeader.frameCount == options.framesPerChunk) {
+				writeChunk();
+			}
+		}
+		if (chunkHeader.frameCount > 0) {
+			writeChunk();
+		}
+
+		TrajectoryFileFooter footer;
+		std::memset(&footer, 0, sizeof(footer));
+		footer.indexOffset = offset;
+		footer.chunkCount = index.size();
+		footer.frameCount = frameCount;
+		std::memcpy(
+			footer.magic, TRAJECTORY_INDEX_MAGIC,
+			sizeof(TRAJECTORY_INDEX_MAGIC));
+		file.write(
+			reinterpret_cast<const char*>(index.data()),
+			index.size() * sizeof(TrajectoryIndexEntry));
+		file.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+		file.flush();
+		if (!file) {
+			throw std::runtime_error("Failed to write trajectory index");
+		}
+	}
+	catch (...) {
+		writeError = std::current_exception();
+	}
+}
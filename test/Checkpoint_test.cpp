@@ -0,0 +1,124 @@
+#include <doctest.h>
+
+#include <PhysicsEngine2D/Simulator.hpp>
+#include <cstring>
+#include <sstream>
+
+static bool sameState(const Simulator& a, const Simulator& b) {
+	if (a.getTime() != b.getTime() ||
+		a.getParticles().size() != b.getParticles().size() ||
+		a.getBalls().size() != b.getBalls().size() ||
+		a.getBoxes().size() != b.getBoxes().size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a.getParticles().size(); i++) {
+		const auto &p = a.getParticles()[i], &q = b.getParticles()[i];
+		if (p.pos.x != q.pos.x || p.pos.y != q.pos.y || p.vel.x != q.vel.x ||
+			p.vel.y != q.vel.y || p.rad != q.rad) {
+			return false;
+		}
+	}
+	for (size_t i = 0; i < a.getBalls().size(); i++) {
+		const auto &p = a.getBalls()[i], &q = b.getBalls()[i];
+		if (p.pos.x != q.pos.x || p.angle != q.angle || p.angVel != q.angVel) {
+			return false;
+		}
+	}
+	for (size_t i = 0; i < a.getBoxes().size(); i++) {
+		const auto &p = a.getBoxes()[i], &q = b.getBoxes()[i];
+		if (p.pos.y != q.pos.y || p.angle != q.angle || p.w != q.w) {
+			return false;
+		}
+	}
+	return true;
+}
+
+TEST_CASE("Test Checkpoint") {
+	Simulator sim(8, 0.9f, 0.8f);
+	sim.addForceField(ForceField::makeUniform(Vector2D(0, -9.8)));
+	sim.addLine(Vector2D(-20, -10), Vector2D(20, -10));
+	sim.addLine(Vector2D(-20, -10), Vector2D(-20, 20));
+	sim.addChain({Vector2D(5, -9.5), Vector2D(10, -7), Vector2D(15, -9.5)});
+	std::vector<Handle<Particle>> handles;
+	for (int i = 0; i < 30; i++) {
+		handles.push_back(sim.addParticle(
+			Vector2D(i - 15, i % 5), Vector2D(0.5, 0), 1, 0.3));
+	}
+	const auto ball = sim.addBall(Vector2D(0, 8), Vector2D(1, 0), 2, 1, 0, 1);
+	sim.addBox(Vector2D(5, 8), Vector2D(-1, 0), 2, 1.5, 0.5);
+	sim.addEmitter(ParticleEmitter(
+		30, {1, 1}, {0.2, 0.4}, {-5, 5, 10, 12}, {0, 0, 0, 0}, {0.5, 2}, 3));
+	// Free slots and a reordered baseShapes must survive too
+	for (int i = 0; i < 30; i += 4) {
+		sim.remove(handles[i]);
+	}
+	sim.setLifetime(handles[1], 1);
+	// Passes through other particles
+	sim.get(handles[2])->mask = ALL_CATEGORIES & ~DYNAMIC_CATEGORY;
+
+	const float dt = 1.0f / 60;
+	for (int step = 0; step < 30; step++) {
+		sim.simulate(dt);
+	}
+
+	std::stringstream checkpoint;
+	sim.save(checkpoint);
+	Simulator restored;
+	restored.load(checkpoint);
+	CHECK(sameState(sim, restored));
+	CHECK(restored.get(handles[1]) != nullptr);
+	CHECK(restored.get(handles[0]) == nullptr);
+	CHECK(restored.get(ball)->angVel == sim.get(ball)->angVel);
+	CHECK(restored.getEmitters().size() == 1);
+	CHECK(restored.getChains().size() == 1);
+	CHECK(restored.get(handles[2])->mask == sim.get(handles[2])->mask);
+
+	// Restored simulation continues exactly, including emitted particles
+	// and expiring lifetimes
+	for (int step = 0; step < 90; step++) {
+		sim.simulate(dt);
+		restored.simulate(dt);
+	}
+	CHECK(sim.get(handles[1]) == nullptr);
+	CHECK(sameState(sim, restored));
+
+	SUBCASE("Invalid Checkpoint") {
+		const auto data = checkpoint.str();
+		const size_t particles = restored.getParticles().size();
+		std::istringstream truncated(data.substr(0, data.size() / 2));
+		CHECK_THROWS_AS(restored.load(truncated), std::invalid_argument);
+		CHECK(restored.getParticles().size() == particles);
+
+		std::istringstream garbage("not a checkpoint at all, clearly");
+		CHECK_THROWS_AS(restored.load(garbage), std::invalid_argument);
+	}
+
+	SUBCASE("Owner Of Removed Slot") {
+		Simulator small;
+		const auto removed = small.addParticle(Vector2D(), Vector2D(), 1, 1);
+		small.addParticle(Vector2D(1, 1), Vector2D(), 1, 1);
+		small.remove(removed);
+		std::stringstream out;
+		small.save(out);
+		auto data = out.str();
+
+		// Owner record of the particle in slot 1, pointed at free slot 0
+		const uint32_t owner[] = {1, 1, DYNAMIC_CATEGORY, ALL_CATEGORIES};
+		const auto at = data.rfind(
+			std::string(reinterpret_cast<const char*>(owner), sizeof(owner)));
+		REQUIRE(at != std::string::npos);
+		const uint32_t freeSlot = 0;
+		std::memcpy(&data[at + sizeof(uint32_t)], &freeSlot, sizeof(freeSlot));
+		std::istringstream patched(data);
+		CHECK_THROWS_AS(restored.load(patched), std::invalid_argument);
+		CHECK(sameState(sim, restored));
+	}
+
+	SUBCASE("Custom Force Field") {
+		Simulator custom;
+		custom.addForceField(ForceField(
+			[](const DynamicShape&, const ForceField&) { return Vector2D(); }));
+		std::stringstream out;
+		CHECK_THROWS_AS(custom.save(out), std::invalid_argument);
+	}
+}
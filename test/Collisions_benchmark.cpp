@@ -38,3 +38,15 @@ BENCHMARK_TEMPLATE(BM_GetCollision, IntervalTreeCollision)
 	->RangeMultiplier(2)
 	->Range(1 << 5, 1 << 16)
 	->Complexity();
+
+BENCHMARK_TEMPLATE(BM_GetCollision, RangeQueryCollision<KdTree<int>>)
+	->RangeMultiplier(2)
+	->Range(1 << 5, 1 << 16)
+	->UseRealTime()
+	->Complexity();
+
+BENCHMARK_TEMPLATE(BM_GetCollision, RangeQueryCollision<RangeTree2D<int>>)
+	->RangeMultiplier(2)
+	->Range(1 << 5, 1 << 16)
+	->UseRealTime()
+	->Complexity();
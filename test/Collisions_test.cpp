@@ -5,10 +5,13 @@
 TYPE_TO_STRING(BruteForceCollision);
 TYPE_TO_STRING(BruteForceSATCollision);
 TYPE_TO_STRING(IntervalTreeCollision);
+TYPE_TO_STRING(RangeQueryCollision<KdTree<int>>);
+TYPE_TO_STRING(RangeQueryCollision<RangeTree2D<int>>);
 
 TEST_CASE_TEMPLATE(
 	"Test Get Collisions", Collision, BruteForceCollision,
-	BruteForceSATCollision, IntervalTreeCollision) {
+	BruteForceSATCollision, IntervalTreeCollision,
+	RangeQueryCollision<KdTree<int>>, RangeQueryCollision<RangeTree2D<int>>) {
 	const size_t length = 1000;
 	for (size_t i = 0; i < length; i++) {
 		auto particles =
@@ -30,4 +33,43 @@ TEST_CASE_TEMPLATE(
 			REQUIRE_EQ(collisionsExpected[i], collisionsGot[i]);
 		}
 	}
-}
\ No newline at end of file
+}
+
+TEST_CASE_TEMPLATE(
+	"Test Collision Filter", Collision, BruteForceCollision,
+	BruteForceSATCollision, IntervalTreeCollision,
+	RangeQueryCollision<KdTree<int>>, RangeQueryCollision<RangeTree2D<int>>) {
+	const size_t length = 500;
+	auto particles =
+		getRandomParticles({-20, 20, -20, 20}, {1, 2}, {1, 2}, length);
+	// Three species, the first passes through itself
+	for (size_t i = 0; i < length; i++) {
+		particles[i].category = 1 << (i % 3 + 2);
+		particles[i].mask = ALL_CATEGORIES & ~(i % 3 == 0 ? 1 << 2 : 0);
+	}
+	std::vector<Line> lines{
+		Line(Vector2D(-20, 0), Vector2D(20, 0)),
+		Line(Vector2D(0, -20), Vector2D(0, 20))};
+	std::vector<std::reference_wrapper<BaseShape>> objects(
+		particles.begin(), particles.end());
+	objects.insert(objects.end(), lines.begin(), lines.end());
+
+	std::vector<std::pair<int, int>> expected;
+	for (size_t i = 0; i < objects.size(); i++) {
+		for (size_t j = i + 1; j < objects.size(); j++) {
+			const auto &a = objects[i].get(), &b = objects[j].get();
+			const bool sameSpecies =
+				i < length && j < length && i % 3 == 0 && j % 3 == 0;
+			const bool bothStatic = i >= length && j >= length;
+			if (a.intersects(b) && !sameSpecies && !bothStatic) {
+				expected.emplace_back(i, j);
+			}
+		}
+	}
+	auto got = Collision::getCollisions(objects);
+	std::sort(got.begin(), got.end());
+	REQUIRE_EQ(expected.size(), got.size());
+	for (size_t i = 0; i < got.size(); i++) {
+		REQUIRE_EQ(expected[i], got[i]);
+	}
+}
@@ -0,0 +1,199 @@
+#include <doctest.h>
+
+#include <PhysicsEngine2D/Contact.hpp>
+#include <PhysicsEngine2D/Simulator.hpp>
+#include <cmath>
+#include <random>
+
+extern std::mt19937 gen;
+
+TEST_CASE("Test Contact") {
+	SUBCASE("Box And Box") {
+		const Box bottom(Vector2D(0, 0), Vector2D(), 1, 2, 1),
+			top(Vector2D(0.2, 0.9), Vector2D(), 1, 1, 1);
+		ContactManifold manifold;
+		REQUIRE(collidePolygons(
+			bottom.corner.data(), 4, top.corner.data(), 4, manifold));
+		CHECK(manifold.pointCount == 2);
+		CHECK(manifold.normal.y == doctest::Approx(1));
+		for (int i = 0; i < manifold.pointCount; i++) {
+			CHECK(manifold.points[i].separation == doctest::Approx(-0.1));
+		}
+
+		// Impulses of persisting points are kept
+		manifold.points[0].normalImpulse = 2;
+		const auto id = manifold.points[0].id;
+		REQUIRE(collidePolygons(
+			bottom.corner.data(), 4, top.corner.data(), 4, manifold));
+		CHECK(manifold.points[0].id == id);
+		CHECK(manifold.points[0].normalImpulse == 2);
+
+		// Separated pair caches the separating axis
+		const Box apart(Vector2D(3, 0), Vector2D(), 1, 1, 1, 0.3);
+		CHECK_FALSE(collidePolygons(
+			bottom.corner.data(), 4, apart.corner.data(), 4, manifold));
+		CHECK(manifold.pointCount == 0);
+		CHECK(manifold.axisOwner >= 0);
+	}
+
+	SUBCASE("Box And Circle") {
+		const Box box(Vector2D(0, 0), Vector2D(), 1, 2, 2, M_PI / 4);
+		ContactManifold manifold;
+		CHECK_FALSE(collideBoxCircle(box, Vector2D(2, 0), 0.5, manifold));
+		REQUIRE(collideBoxCircle(box, Vector2D(1.6, 0), 0.5, manifold));
+		CHECK(manifold.normal.x == doctest::Approx(1));
+		CHECK(manifold.points[0].separation ==
+			  doctest::Approx(1.6 - std::sqrt(2) - 0.5));
+	}
+
+	SUBCASE("Stack Rests") {
+		Simulator sim(10, 0.5f, 0.5f);
+		sim.addForceField(ForceField::makeUniform(Vector2D(0, -9.8)));
+		sim.addLine(Vector2D(-20, 0), Vector2D(20, 0));
+		const auto bottom = sim.addBox(Vector2D(0, 0.5), Vector2D(), 1, 2, 1);
+		const auto top = sim.addBox(Vector2D(0, 1.6), Vector2D(), 1, 1, 1);
+		for (int step = 0; step < 180; step++) {
+			sim.simulate(1.0f / 60);
+		}
+		CHECK(sim.get(bottom)->pos.y == doctest::Approx(0.5).epsilon(0.05));
+		CHECK(sim.get(top)->pos.y == doctest::Approx(1.5).epsilon(0.05));
+		CHECK(std::abs(sim.get(top)->angle) < 0.05);
+	}
+
+	SUBCASE("Solver Stacks With One Substep") {
+		Simulator sim(1, 0.5f, 0.5f);
+		sim.addForceField(ForceField::makeUniform(Vector2D(0, -9.8)));
+		sim.addLine(Vector2D(-20, 0), Vector2D(20, 0));
+		const auto bottom = sim.addBox(Vector2D(0, 0.5), Vector2D(), 1, 1, 1);
+		const auto top = sim.addBox(Vector2D(0, 1.5), Vector2D(), 1, 1, 1);
+		for (int step = 0; step < 240; step++) {
+			sim.simulate(1.0f / 60);
+		}
+		CHECK(sim.get(bottom)->pos.y == doctest::Approx(0.5).epsilon(0.05));
+		CHECK(sim.get(top)->pos.y == doctest::Approx(1.5).epsilon(0.05));
+		CHECK(sim.get(top)->vel.len() < 0.05);
+	}
+
+	SUBCASE("Touching Circle Line Pairs") {
+		// Not a multiple of the SIMD width, so the scalar tail runs too
+		const size_t count = 203;
+		std::uniform_real_distribution<dataType> coord(-5, 5), radius(0.1, 2);
+		std::vector<Line> lines;
+		std::vector<Vector2D> centers;
+		std::vector<dataType> radii;
+		CircleLinePairs pairs(count, std::pmr::get_default_resource());
+		for (size_t i = 0; i < count; i++) {
+			lines.emplace_back(
+				Vector2D(coord(gen), coord(gen)), Vector2D(coord(gen), coord(gen)));
+			centers.emplace_back(coord(gen), coord(gen));
+			radii.push_back(radius(gen));
+			pairs.set(i, centers[i], radii[i], lines[i]);
+		}
+		std::vector<uint32_t> touching(count);
+		touching.resize(findTouchingPairs(pairs, touching.data()));
+		std::vector<uint32_t> expected;
+		for (uint32_t i = 0; i < count; i++) {
+			ContactManifold manifold;
+			if (collideCircleLine(centers[i], radii[i], lines[i], manifold)) {
+				expected.push_back(i);
+			}
+		}
+		CHECK(!expected.empty());
+		CHECK(touching == expected);
+	}
+
+	SUBCASE("Circle Pushed Into Second Line") {
+		// Particle only overlaps the bottom of an acute wedge, getting
+		// pushed out of it moves it into the top
+		Simulator sim(1, 0, 0);
+		sim.addLine(Vector2D(0, 0), Vector2D(10, 0));
+		sim.addLine(Vector2D(0, 0), Vector2D(10, 3));
+		sim.addParticle(Vector2D(3, 0.3), Vector2D(), 1, 0.5);
+		sim.simulate(1.0f / 60);
+		CHECK(sim.getStats().contacts == 2);
+	}
+
+	SUBCASE("Bounce Off Line Keeps Energy") {
+		Simulator sim(10, 0.8f, 0);
+		sim.addForceField(ForceField::makeUniform(Vector2D(0, -9.8)));
+		sim.addLine(Vector2D(-10, 0), Vector2D(10, 0));
+		const auto particle =
+			sim.addParticle(Vector2D(0, 2), Vector2D(), 1, 0.5);
+		const auto energy = [&]() {
+			const auto& p = *sim.get(particle);
+			return 0.5f * p.vel.lenSq() + 9.8f * (p.pos.y - 0.5f);
+		};
+		// Free fall gains a little energy from integration, bounces must
+		// lose more than that
+		float apex = energy();
+		int bounces = 0;
+		for (int step = 0; step < 600; step++) {
+			const bool rising = sim.get(particle)->vel.y > 0;
+			sim.simulate(1.0f / 60);
+			CHECK(energy() <= apex + 0.05f);
+			if (rising && sim.get(particle)->vel.y <= 0) {
+				CHECK(energy() < apex);
+				apex = energy();
+				bounces++;
+			}
+		}
+		CHECK(bounces >= 3);
+	}
+
+	SUBCASE("Circle At Chain Joint") {
+		ContactManifold first, second;
+		const Chain flat({Vector2D(-1, 0), Vector2D(0, 0), Vector2D(1, 0)});
+		CHECK(!collideCircleChain(Vector2D(0, 0.4), 0.5, flat, 0, first));
+		CHECK(collideCircleChain(Vector2D(0, 0.4), 0.5, flat, 1, second));
+
+		// Both sides of a valley touch the circle
+		const Chain valley({Vector2D(-1, 1), Vector2D(0, 0), Vector2D(1, 1)});
+		CHECK(collideCircleChain(Vector2D(0, 0.4), 0.5, valley, 0, first));
+		CHECK(collideCircleChain(Vector2D(0, 0.4), 0.5, valley, 1, second));
+		CHECK(first.normal.x == doctest::Approx(-second.normal.x));
+	}
+
+	SUBCASE("Chain With Repeated Vertex") {
+		const Chain chain(
+			{Vector2D(0, 1), Vector2D(5, 1), Vector2D(5, 1), Vector2D(10, 1)});
+		REQUIRE(chain.segmentCount() == 2);
+		ContactManifold manifold;
+		for (uint32_t segment = 0; segment < 2; segment++) {
+			CHECK(!collideCircleChain(
+				Vector2D(5, 5), 0.5, chain, segment, manifold));
+		}
+		CHECK_THROWS_AS(
+			Chain({Vector2D(1, 1), Vector2D(1, 1)}), std::invalid_argument);
+
+		Simulator sim(10, 0, 0);
+		sim.addForceField(ForceField::makeUniform(Vector2D(0, -9.8)));
+		sim.addChain(
+			{Vector2D(0, 1), Vector2D(5, 1), Vector2D(5, 1), Vector2D(10, 1)});
+		const auto particle =
+			sim.addParticle(Vector2D(5, 1.5), Vector2D(), 1, 0.5);
+		for (int step = 0; step < 30; step++) {
+			sim.simulate(1.0f / 60);
+		}
+		CHECK(std::isfinite(sim.get(particle)->pos.y));
+		CHECK(sim.get(particle)->pos.y == doctest::Approx(1.5).epsilon(0.01));
+	}
+
+	SUBCASE("Box Slides Over Chain Joints") {
+		Simulator sim(10, 0, 0);
+		sim.addForceField(ForceField::makeUniform(Vector2D(0, -9.8)));
+		std::vector<Vector2D> vertices;
+		for (int x = -20; x <= 20; x++) {
+			vertices.emplace_back(x, 0);
+		}
+		sim.addChain(vertices);
+		// Starts overlapping, so it rests slop deep in the chain
+		const auto box =
+			sim.addBox(Vector2D(-15, 0.45), Vector2D(2, 0), 1, 1, 1);
+		for (int step = 0; step < 120; step++) {
+			sim.simulate(1.0f / 60);
+		}
+		CHECK(sim.get(box)->vel.x == doctest::Approx(2).epsilon(0.01));
+		CHECK(sim.get(box)->pos.y == doctest::Approx(0.5).epsilon(0.05));
+		CHECK(std::abs(sim.get(box)->angle) < 0.01);
+	}
+}
@@ -0,0 +1,43 @@
+#include <doctest.h>
+
+#include <PhysicsEngine2D/Emitter.hpp>
+#include <PhysicsEngine2D/Simulator.hpp>
+
+TEST_CASE("Test Particle Emitter") {
+	Simulator sim(10, 0.9f, 0.9f);
+	sim.addForceField(ForceField([](const DynamicShape& a, const ForceField&) {
+		return Vector2D(0, -9.8f) * a.mass;
+	}));
+	sim.addLine(Vector2D(-50, -10), Vector2D(50, -10));
+	const auto emitter = sim.addEmitter(ParticleEmitter(
+		120, {1, 1}, {0.25, 0.5}, {-5, 5, 0, 5}, {-1, 1, 0, 1}, {1, 1}, 7));
+	REQUIRE(sim.getEmitter(emitter) != nullptr);
+
+	const float dt = 1.0f / 60;
+	for (int step = 0; step < 30; step++) {
+		sim.simulate(dt);
+		for (auto& particle : sim.getParticles()) {
+			CHECK(particle.rad >= 0.25);
+			CHECK(particle.rad <= 0.5);
+		}
+	}
+	// Half a second at 120 particles per second, none expired yet
+	CHECK(sim.getParticles().size() >= 58);
+	CHECK(sim.getParticles().size() <= 61);
+
+	// Warm up until lifetimes start to expire and capacities settle
+	size_t expired = 0;
+	for (int step = 0; step < 300; step++) {
+		sim.simulate(dt);
+		expired += sim.getStats().expired;
+	}
+	CHECK(expired > 0);
+	CHECK(sim.getParticles().size() <= 125);
+
+	SUBCASE("Remove Emitter") {
+		REQUIRE(sim.removeEmitter(emitter));
+		CHECK(sim.getEmitter(emitter) == nullptr);
+		for (int step = 0; step < 90; step++) sim.simulate(dt);
+		CHECK(sim.getParticles().empty());
+	}
+}
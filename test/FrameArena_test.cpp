@@ -0,0 +1,72 @@
+#include <doctest.h>
+
+#include <PhysicsEngine2D/Collisions.hpp>
+#include <PhysicsEngine2D/FrameArena.hpp>
+#include <PhysicsEngine2D/KdTree.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "TestUtil.hpp"
+
+TEST_CASE("Test Frame Arena") {
+	SUBCASE("Alignment And Growth") {
+		FrameArena arena(256);
+		for (size_t alignment : {1, 2, 4, 8, 16, 32, 64}) {
+			for (int i = 0; i < 10; i++) {
+				void* p = arena.allocate(3 + 7 * i, alignment);
+				CHECK(reinterpret_cast<uintptr_t>(p) % alignment == 0);
+			}
+		}
+		void* big = arena.allocate(1 << 12, 8);
+		CHECK(big != nullptr);
+		CHECK(arena.capacity() >= (1 << 12) + 256);
+		CHECK(arena.bytesUsed() >= (1 << 12));
+	}
+
+	SUBCASE("Reset Reuses Memory") {
+		FrameArena arena(64);
+		for (int frame = 0; frame < 3; frame++) {
+			arena.reset();
+			std::pmr::vector<int> values(&arena);
+			for (int i = 0; i < 1000; i++) values.push_back(i);
+			CHECK(values.back() == 999);
+		}
+		const size_t capacity = arena.capacity();
+		for (int frame = 0; frame < 3; frame++) {
+			arena.reset();
+			std::pmr::vector<int> values(&arena);
+			for (int i = 0; i < 1000; i++) values.push_back(i);
+		}
+		CHECK(arena.capacity() == capacity);
+		CHECK(arena.peakBytesUsed() <= capacity);
+	}
+
+	SUBCASE("Collisions And Queries On Arena") {
+		FrameArena arena;
+		auto particles =
+			getRandomParticles({-40, 40, -40, 40}, {1, 2}, {1, 2}, 500);
+		std::vector<std::reference_wrapper<BaseShape>> objects(
+			particles.begin(), particles.end());
+		const auto expected = getCollisionBruteForce(objects);
+		for (int frame = 0; frame < 2; frame++) {
+			arena.reset();
+			auto sat = getCollisionBruteForceSAT(objects, &arena);
+			auto intervalTree = getCollisionIntervalTree(objects, &arena);
+			std::sort(intervalTree.begin(), intervalTree.end());
+			CHECK(sat.get_allocator().resource() == &arena);
+			REQUIRE(sat.size() == expected.size());
+			REQUIRE(intervalTree.size() == expected.size());
+			for (size_t i = 0; i < expected.size(); i++) {
+				CHECK(sat[i] == expected[i]);
+				CHECK(intervalTree[i] == expected[i]);
+			}
+		}
+
+		const auto tree =
+			getRandomRangeTree<KdTree<int>>({-40, 40, -40, 40}, 500);
+		std::pmr::vector<int> insides(&arena);
+		tree.rangeQuery({-10, 10, -10, 10}, insides);
+		auto expectedInsides = tree.rangeQuery({-10, 10, -10, 10});
+		CHECK(insides.size() == expectedInsides.size());
+	}
+}
@@ -0,0 +1,105 @@
+#include <doctest.h>
+
+#include <PhysicsEngine2D/IntervalTree.hpp>
+#include <algorithm>
+#include <random>
+
+#include "TestUtil.hpp"
+
+extern std::mt19937 gen;
+
+TEST_CASE("Test AVL Interval Tree") {
+	const size_t length = 1000;
+	std::uniform_real_distribution<> pos(-400, 400), size(1, 40);
+
+	std::vector<Range<double>> ranges;
+	std::vector<int> values = getShuffledArrayOf1ToN(length);
+	for (size_t i = 0; i < length; i++) {
+		const auto start = pos(gen);
+		ranges.emplace_back(start, start + size(gen));
+	}
+
+	auto expectedSearch = [&](double low, double high,
+							  const std::vector<bool>& present) {
+		std::vector<int> list;
+		for (size_t i = 0; i < length; i++) {
+			if (present[i] && ranges[i].intersects({low, high})) {
+				list.emplace_back(values[i]);
+			}
+		}
+		std::sort(list.begin(), list.end());
+		return list;
+	};
+
+	auto checkTree = [&](AVL<double, int>& tree,
+						 const std::vector<bool>& present) {
+		std::vector<std::pair<Range<double>, int>> sorted;
+		for (size_t i = 0; i < length; i++) {
+			if (present[i]) {
+				sorted.emplace_back(ranges[i], values[i]);
+			}
+		}
+		std::sort(sorted.begin(), sorted.end());
+		auto inOrder = tree.getInOrder();
+		REQUIRE_EQ(inOrder.size(), sorted.size());
+		for (size_t i = 0; i < sorted.size(); i++) {
+			REQUIRE_EQ(inOrder[i], sorted[i].second);
+		}
+
+		for (size_t i = 0; i < 100; i++) {
+			const auto low = pos(gen), high = low + size(gen);
+			auto got = tree.searchAll(low, high);
+			std::sort(got.begin(), got.end());
+			auto expected = expectedSearch(low, high, present);
+			CAPTURE(low);
+			CAPTURE(high);
+			REQUIRE(got == expected);
+		}
+	};
+
+	SUBCASE("Insert and Remove") {
+		AVL<double, int> tree;
+		std::vector<bool> present(length, false);
+		for (size_t i = 0; i < length; i++) {
+			tree.insert(ranges[i].start, ranges[i].end, values[i]);
+			present[i] = true;
+		}
+		checkTree(tree, present);
+
+		for (size_t i = 0; i < length; i += 2) {
+			tree.remove(ranges[i].start, ranges[i].end, values[i]);
+			present[i] = false;
+		}
+		checkTree(tree, present);
+
+		for (size_t i = 1; i < length; i += 2) {
+			tree.remove(ranges[i].start, ranges[i].end, values[i]);
+		}
+		REQUIRE(tree.empty());
+	}
+
+	SUBCASE("Bulk Load") {
+		std::vector<std::pair<Range<double>, int>> sorted;
+		for (size_t i = 0; i < length; i++) {
+			sorted.emplace_back(ranges[i], values[i]);
+		}
+		std::sort(sorted.begin(), sorted.end());
+		std::vector<Range<double>> sortedRanges;
+		std::vector<int> sortedValues;
+		for (auto& elem : sorted) {
+			sortedRanges.emplace_back(elem.first);
+			sortedValues.emplace_back(elem.second);
+		}
+
+		AVL<double, int> tree;
+		tree.bulkLoad(sortedRanges, sortedValues);
+		std::vector<bool> present(length, true);
+		checkTree(tree, present);
+
+		for (size_t i = 0; i < length; i += 3) {
+			tree.remove(ranges[i].start, ranges[i].end, values[i]);
+			present[i] = false;
+		}
+		checkTree(tree, present);
+	}
+}
@@ -1,11 +1,124 @@
 #include <benchmark/benchmark.h>
 
+#include <PhysicsEngine2D/ImplicitKdTree.hpp>
 #include <PhysicsEngine2D/KdTree.hpp>
 #include <PhysicsEngine2D/RangeTree2D.hpp>
 #include <random>
 
 #include "TestUtil.hpp"
 
+extern std::mt19937 gen;
+
+enum PointDistribution { UNIFORM, CLUSTERED, GAUSSIAN_BLOBS, LINE_ALIGNED };
+
+const Range2D<dataType> benchmarkBounds(-512, 512, -512, 512);
+
+std::vector<Vector2D> getDistributedPoints(int distribution, size_t N) {
+	switch (distribution) {
+		case CLUSTERED:
+			return getClusteredPoints(benchmarkBounds, N);
+		case GAUSSIAN_BLOBS:
+			return getGaussianBlobPoints(benchmarkBounds, N);
+		case LINE_ALIGNED:
+			return getLineAlignedPoints(benchmarkBounds, N);
+		default:
+			return getRandomPoints(benchmarkBounds, N);
+	}
+}
+
+// Square queries covering `ppm` parts per million of the bounds, centered on
+// data points so that clustered data is queried where it actually is
+std::vector<Range2D<dataType>> getSelectivityQueries(
+	const std::vector<Vector2D>& points, int64_t ppm, size_t count) {
+	const dataType width = benchmarkBounds.rangeX.end -
+						   benchmarkBounds.rangeX.start,
+				   side = width * std::sqrt(ppm / 1e6f);
+	std::uniform_int_distribution<size_t> index(0, points.size() - 1);
+	std::vector<Range2D<dataType>> queries;
+	queries.reserve(count);
+	for (size_t i = 0; i < count; i++) {
+		const auto& center = points[index(gen)];
+		queries.emplace_back(
+			center.x - side / 2, center.x + side / 2, center.y - side / 2,
+			center.y + side / 2);
+	}
+	return queries;
+}
+
+/**
+ * Args: distribution, number of points
+ */
+template <class Tree> void BM_BuildTreeDistribution(benchmark::State& state) {
+	const size_t N = state.range(1);
+	auto points = getDistributedPoints(state.range(0), N);
+	auto values = getShuffledArrayOf1ToN(N);
+
+	size_t bytes = 0;
+	for (auto _ : state) {
+		Tree tree(points, values);
+		bytes = tree.memoryUsage();
+	}
+	state.SetItemsProcessed(state.iterations() * N);
+	state.counters["bytes_per_point"] = double(bytes) / N;
+}
+
+/**
+ * Args: distribution, number of points, selectivity in parts per million
+ */
+template <class Tree> void BM_RangeQueryDistribution(benchmark::State& state) {
+	const size_t N = state.range(1);
+	auto points = getDistributedPoints(state.range(0), N);
+	auto values = getShuffledArrayOf1ToN(N);
+	const Tree tree(points, values);
+	const auto queries = getSelectivityQueries(points, state.range(2), 1024);
+
+	size_t i = 0, hits = 0;
+	std::vector<int> insides;
+	for (auto _ : state) {
+		insides.clear();
+		tree.rangeQuery(queries[i++ & 1023], insides);
+		hits += insides.size();
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.counters["hits_per_query"] =
+		benchmark::Counter(hits, benchmark::Counter::kAvgIterations);
+	state.counters["bytes_per_point"] = double(tree.memoryUsage()) / N;
+}
+
+/**
+ * Args: distribution, number of points, selectivity in parts per million
+ */
+template <class Tree> void BM_CountQueryDistribution(benchmark::State& state) {
+	const size_t N = state.range(1);
+	auto points = getDistributedPoints(state.range(0), N);
+	auto values = getShuffledArrayOf1ToN(N);
+	const Tree tree(points, values);
+	const auto queries = getSelectivityQueries(points, state.range(2), 1024);
+
+	size_t i = 0, hits = 0;
+	for (auto _ : state) {
+		hits += tree.countQuery(queries[i++ & 1023]);
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.counters["hits_per_query"] =
+		benchmark::Counter(hits, benchmark::Counter::kAvgIterations);
+}
+
+void distributionArgs(benchmark::internal::Benchmark* b) {
+	b->ArgNames({"dist", "n"})->ArgsProduct(
+		{{UNIFORM, CLUSTERED, GAUSSIAN_BLOBS, LINE_ALIGNED},
+		 {1 << 12, 1 << 16, 1 << 18}});
+}
+
+void selectivityArgs(benchmark::internal::Benchmark* b) {
+	// 0.01%, 0.1%, 1% and 10% of the area
+	b->ArgNames({"dist", "n", "ppm"})
+		->ArgsProduct(
+			{{UNIFORM, CLUSTERED, GAUSSIAN_BLOBS, LINE_ALIGNED},
+			 {1 << 12, 1 << 16, 1 << 18},
+			 {100, 1000, 10000, 100000}});
+}
+
 template <class Tree> void BM_BuildTree(benchmark::State& state) {
 	auto points = getRandomPoints({-400, 400, -400, 400}, state.range());
 	auto values = getShuffledArrayOf1ToN(state.range());
@@ -26,11 +139,31 @@ template <class Tree> void BM_RangeQuery(benchmark::State& state) {
 	state.SetComplexityN(state.range(0));
 }
 
+template <class Tree> void BM_BatchRangeQuery(benchmark::State& state) {
+	Tree tree = getRandomRangeTree<Tree>({-512, 512, -512, 512}, state.range());
+	std::vector<Range2D<dataType>> queries;
+	for (int64_t i = 0; i < state.range(); i++) {
+		queries.emplace_back(
+			getRandom2DRange({-512, 512, -512, 512}, {10, 10, 10, 10}));
+	}
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(tree.rangeQuery(queries));
+	}
+	state.SetItemsProcessed(state.iterations() * queries.size());
+	state.SetComplexityN(state.range(0));
+}
+
 BENCHMARK_TEMPLATE(BM_BuildTree, KdTree<int>)
 	->Range(1 << 5, 1 << 18)
 	->Complexity();
 
 BENCHMARK_TEMPLATE(BM_BuildTree, RangeTree2D<int>)
+	->Range(1 << 5, 1 << 18)
+	->UseRealTime()
+	->Complexity();
+
+BENCHMARK_TEMPLATE(BM_BuildTree, ImplicitKdTree<int>)
 	->Range(1 << 5, 1 << 18)
 	->Complexity();
 
@@ -43,3 +176,46 @@ BENCHMARK_TEMPLATE(BM_RangeQuery, RangeTree2D<int>)
 	->RangeMultiplier(2)
 	->Range(1 << 5, 1 << 18)
 	->Complexity();
+
+BENCHMARK_TEMPLATE(BM_RangeQuery, ImplicitKdTree<int>)
+	->RangeMultiplier(2)
+	->Range(1 << 5, 1 << 18)
+	->Complexity();
+
+BENCHMARK_TEMPLATE(BM_BatchRangeQuery, KdTree<int>)
+	->RangeMultiplier(4)
+	->Range(1 << 6, 1 << 18)
+	->UseRealTime()
+	->Complexity();
+
+BENCHMARK_TEMPLATE(BM_BatchRangeQuery, RangeTree2D<int>)
+	->RangeMultiplier(4)
+	->Range(1 << 6, 1 << 18)
+	->UseRealTime()
+	->Complexity();
+
+BENCHMARK_TEMPLATE(BM_BatchRangeQuery, ImplicitKdTree<int>)
+	->RangeMultiplier(4)
+	->Range(1 << 6, 1 << 18)
+	->UseRealTime()
+	->Complexity();
+
+BENCHMARK_TEMPLATE(BM_BuildTreeDistribution, KdTree<int>)
+	->Apply(distributionArgs);
+BENCHMARK_TEMPLATE(BM_BuildTreeDistribution, RangeTree2D<int>)
+	->Apply(distributionArgs)
+	->UseRealTime();
+BENCHMARK_TEMPLATE(BM_BuildTreeDistribution, ImplicitKdTree<int>)
+	->Apply(distributionArgs);
+
+BENCHMARK_TEMPLATE(BM_RangeQueryDistribution, KdTree<int>)
+	->Apply(selectivityArgs);
+BENCHMARK_TEMPLATE(BM_RangeQueryDistribution, RangeTree2D<int>)
+	->Apply(selectivityArgs);
+BENCHMARK_TEMPLATE(BM_RangeQueryDistribution, ImplicitKdTree<int>)
+	->Apply(selectivityArgs);
+
+BENCHMARK_TEMPLATE(BM_CountQueryDistribution, KdTree<int>)
+	->Apply(selectivityArgs);
+BENCHMARK_TEMPLATE(BM_CountQueryDistribution, RangeTree2D<int>)
+	->Apply(selectivityArgs);
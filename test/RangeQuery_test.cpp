@@ -1,5 +1,6 @@
 #include <doctest.h>
 
+#include <PhysicsEngine2D/ImplicitKdTree.hpp>
 #include <PhysicsEngine2D/KdTree.hpp>
 #include <PhysicsEngine2D/RangeTree2D.hpp>
 
@@ -7,9 +8,11 @@
 
 TYPE_TO_STRING(KdTree<int>);
 TYPE_TO_STRING(RangeTree2D<int>);
+TYPE_TO_STRING(ImplicitKdTree<int>);
 
 TEST_CASE_TEMPLATE(
-	"Test RangeTree Range Query", Tree, KdTree<int>, RangeTree2D<int>) {
+	"Test RangeTree Range Query", Tree, KdTree<int>, RangeTree2D<int>,
+	ImplicitKdTree<int>) {
 	SUBCASE("Empty Input") {
 		std::vector<Vector2D> points(0);
 		std::vector<int> values(0);
@@ -76,4 +79,89 @@ TEST_CASE_TEMPLATE(
 			}
 		}
 	}
-}
\ No newline at end of file
+
+	SUBCASE("Large Random Input") {
+		const size_t length = 1 << 17;
+		auto points = getRandomPoints({-400, 400, -400, 400}, length);
+		auto values = getShuffledArrayOf1ToN(length);
+		Tree tree(points, values);
+		for (size_t i = 0; i < 100; i++) {
+			auto range2D =
+				getRandom2DRange({-400, 400, -400, 400}, {10, 400, 10, 400});
+
+			auto insidePointsGot = tree.rangeQuery(range2D);
+			std::vector<int> insidePointsActual;
+			for (size_t j = 0; j < length; j++) {
+				if (range2D.contains(points[j])) {
+					insidePointsActual.emplace_back(values[j]);
+				}
+			}
+
+			std::sort(insidePointsGot.begin(), insidePointsGot.end());
+			std::sort(insidePointsActual.begin(), insidePointsActual.end());
+
+			CAPTURE(range2D);
+			REQUIRE_EQ(insidePointsActual.size(), insidePointsGot.size());
+			REQUIRE(insidePointsActual == insidePointsGot);
+		}
+	}
+}
+
+TEST_CASE_TEMPLATE(
+	"Test RangeTree Batch Range Query", Tree, KdTree<int>, RangeTree2D<int>,
+	ImplicitKdTree<int>) {
+	const size_t length = 1000;
+	auto points = getRandomPoints({-400, 400, -400, 400}, length);
+	auto values = getShuffledArrayOf1ToN(length);
+	Tree tree(points, values);
+
+	std::vector<Range2D<dataType>> queries;
+	for (size_t i = 0; i < 4 * length; i++) {
+		queries.emplace_back(
+			getRandom2DRange({-400, 400, -400, 400}, {10, 400, 10, 400}));
+	}
+
+	auto result = tree.rangeQuery(queries);
+	REQUIRE_EQ(result.size(), queries.size());
+	for (size_t i = 0; i < queries.size(); i++) {
+		std::vector<int> insidePointsGot(result.begin(i), result.end(i));
+		auto insidePointsExpected = tree.rangeQuery(queries[i]);
+
+		std::sort(insidePointsGot.begin(), insidePointsGot.end());
+		std::sort(insidePointsExpected.begin(), insidePointsExpected.end());
+
+		CAPTURE(queries[i]);
+		REQUIRE(insidePointsExpected == insidePointsGot);
+	}
+}
+
+TEST_CASE_TEMPLATE(
+	"Test RangeTree Aggregate Query", Tree, KdTree<int>, RangeTree2D<int>) {
+	const size_t length = 1000;
+	auto points = getRandomPoints({-400, 400, -400, 400}, length);
+	auto values = getShuffledArrayOf1ToN(length);
+	std::vector<double> weights(values.begin(), values.end());
+	Tree weightedTree(points, values, weights);
+	Tree tree(points, values);
+
+	for (size_t i = 0; i < length; i++) {
+		auto range2D =
+			getRandom2DRange({-400, 400, -400, 400}, {10, 400, 10, 400});
+
+		RangeAggregate expected;
+		for (size_t j = 0; j < length; j++) {
+			if (range2D.contains(points[j])) {
+				expected.add(points[j], weights[j]);
+			}
+		}
+		auto got = weightedTree.aggregateQuery(range2D);
+
+		CAPTURE(range2D);
+		REQUIRE_EQ(expected.count, got.count);
+		REQUIRE_EQ(expected.count, weightedTree.countQuery(range2D));
+		REQUIRE_EQ(expected.count, tree.countQuery(range2D));
+		REQUIRE_EQ(got.weight, doctest::Approx(expected.weight));
+		REQUIRE_EQ(got.centroid().x, doctest::Approx(expected.centroid().x));
+		REQUIRE_EQ(got.centroid().y, doctest::Approx(expected.centroid().y));
+	}
+}
@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+
+#include <PhysicsEngine2D/Scene.hpp>
+#include <PhysicsEngine2D/Simulator.hpp>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#ifndef SCENE_DIRECTORY
+#define SCENE_DIRECTORY "example/cpp"
+#endif
+
+static const uint32_t SCENE_SEED = 42;
+
+/**
+ * Steps an example scene at 60 steps per simulated second, same as viewer
+ */
+static void BM_Scene(benchmark::State& state, const char* fileName) {
+	Simulator sceneSim(10, 0.9f, 0.9f);
+	loadScene(
+		std::filesystem::path(SCENE_DIRECTORY) / fileName, sceneSim,
+		SCENE_SEED);
+	// Emitters change number of bodies while running
+	size_t bodySteps = 0;
+	for (auto _ : state) {
+		sceneSim.simulate(1.0f / 60);
+		bodySteps += sceneSim.getBaseShapes().size();
+	}
+	state.counters["bodies"] = sceneSim.getBaseShapes().size();
+	state.counters["steps/s"] = benchmark::Counter(
+		state.iterations(), benchmark::Counter::kIsRate);
+	state.counters["bodySteps/s"] =
+		benchmark::Counter(bodySteps, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK_CAPTURE(BM_Scene, bouncingBall, "bouncingBall.txt");
+BENCHMARK_CAPTURE(BM_Scene, endlessGaltonBoard, "endlessGaltonBoard.txt");
+BENCHMARK_CAPTURE(BM_Scene, frictionTest, "frictionTest.txt");
+BENCHMARK_CAPTURE(BM_Scene, galtonBoard, "galtonBoard.txt");
+BENCHMARK_CAPTURE(BM_Scene, gravityTest, "gravityTest.txt");
+BENCHMARK_CAPTURE(BM_Scene, rollingTest, "rollingTest.txt");
+
+/**
+ * Loads a scene of state.range(0) lines, as text or as a mapped binary file
+ */
+static void BM_LoadScene(benchmark::State& state, bool binary) {
+	std::mt19937 gen(SCENE_SEED);
+	std::uniform_real_distribution<> coordinate(-100, 100);
+	std::ostringstream text;
+	text.precision(9);
+	for (int i = 0; i < state.range(0); i++) {
+		text << "LINE " << coordinate(gen) << " " << coordinate(gen) << " "
+			 << coordinate(gen) << " " << coordinate(gen) << "\n";
+	}
+	const auto path = std::filesystem::temp_directory_path() /
+					  (binary ? "BM_LoadScene.bin" : "BM_LoadScene.txt");
+	{
+		std::ofstream file(path, std::ios::binary);
+		if (binary) {
+			std::istringstream in(text.str());
+			writeBinaryScene(file, parseScene(in, SCENE_SEED).view());
+		}
+		else {
+			file << text.str();
+		}
+	}
+	Simulator sim;
+	for (auto _ : state) {
+		loadScene(path, sim, SCENE_SEED);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	std::filesystem::remove(path);
+}
+
+BENCHMARK_CAPTURE(BM_LoadScene, text, false)->Arg(100000);
+BENCHMARK_CAPTURE(BM_LoadScene, binary, true)->Arg(100000);
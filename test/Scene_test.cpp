@@ -0,0 +1,170 @@
+#include <doctest.h>
+
+#include <PhysicsEngine2D/Scene.hpp>
+#include <PhysicsEngine2D/Simulator.hpp>
+#include <algorithm>
+#include <sstream>
+
+TEST_CASE("Test Scene Loading") {
+	Simulator sim;
+
+	SUBCASE("Valid Scene") {
+		std::istringstream scene(
+			"SIZE 1000 800 -50 40 50 -40\n"
+			"TITLE Test Scene\n"
+			"# comment\n"
+			"\n"
+			"GRAVITY 0 -9.8\n"
+			"LINE -45 -35 45 -35\n"
+			"CHAIN -45 -35 0 -40 45 -35\n"
+			"PARTICLE 1 2 0 0\n"
+			"PARTICLE 1 2 5 5 1 -1\n"
+			"BALL 1 2 10 10 0 0 0.5 1\n"
+			"REPEAT 20 PARTICLE 0.2 1 0.25 0.25 -25 25 32 40\n"
+			"END\n"
+			"PARTICLE 1 2 0 0\n");
+		const auto info = loadScene(scene, sim, 42);
+		CHECK(info.title == "Test Scene");
+		CHECK(info.width == 1000);
+		CHECK(info.height == 800);
+		CHECK(info.topLeft.x == -50);
+		CHECK(info.bottomRight.y == -40);
+		CHECK(sim.getLines().size() == 1);
+		REQUIRE(sim.getChains().size() == 1);
+		CHECK(sim.getChains()[0].segmentCount() == 2);
+		CHECK(sim.getParticles().size() == 22);
+		CHECK(sim.getBalls().size() == 1);
+		CHECK(sim.getParticles()[1].vel.y == -1);
+	}
+
+	SUBCASE("Same Seed Same Scene") {
+		const std::string text = "REPEAT 10 PARTICLE 1 2 1 2 -5 5 -5 5\n";
+		Simulator other;
+		std::istringstream first(text), second(text);
+		loadScene(first, sim, 7);
+		loadScene(second, other, 7);
+		REQUIRE(sim.getParticles().size() == 10);
+		for (size_t i = 0; i < 10; i++) {
+			CHECK(sim.getParticles()[i].pos.x == other.getParticles()[i].pos.x);
+			CHECK(sim.getParticles()[i].pos.y == other.getParticles()[i].pos.y);
+		}
+	}
+
+	SUBCASE("Write And Load") {
+		Simulator written;
+		written.addLine(Vector2D(-1, 0), Vector2D(1, 0.5));
+		written.addChain({Vector2D(-1, 0), Vector2D(0, -1), Vector2D(1, 0.25)});
+		written.addParticle(Vector2D(0.1, 0.2), Vector2D(0.3, -0.4), 1.5, 0.7);
+		written.addBall(Vector2D(2, 3), Vector2D(-1, 1), 2, 0.5, 0.25, -0.125);
+		std::stringstream scene;
+		writeScene(scene, written);
+
+		Simulator other;
+		loadScene(scene, other);
+		REQUIRE(other.getLines().size() == 1);
+		REQUIRE(other.getParticles().size() == 1);
+		REQUIRE(other.getBalls().size() == 1);
+		REQUIRE(other.getChains().size() == 1);
+		CHECK(
+			other.getChains()[0].getVertices() ==
+			written.getChains()[0].getVertices());
+		CHECK(other.getLines()[0].end.y == written.getLines()[0].end.y);
+		CHECK(other.getParticles()[0].pos.x == written.getParticles()[0].pos.x);
+		CHECK(other.getParticles()[0].vel.y == written.getParticles()[0].vel.y);
+		CHECK(other.getParticles()[0].rad == written.getParticles()[0].rad);
+		CHECK(other.getBalls()[0].angle == written.getBalls()[0].angle);
+		CHECK(other.getBalls()[0].angVel == written.getBalls()[0].angVel);
+	}
+
+	SUBCASE("Binary Round Trip") {
+		std::istringstream text(
+			"SIZE 640 480 -10 10 10 -10\n"
+			"TITLE Binary\n"
+			"GRAVITY 0 -9.8\n"
+			"LINE -5 -5 5 -5\n"
+			"CHAIN -5 -5 0 -6 5 -5\n"
+			"BALL 1 2 3 4 0 0 0.5 1\n"
+			"BOX 2 1 0.5 0 1 0 0 0.25\n"
+			"REPEAT 5 PARTICLE 1 2 1 2 -5 5 -5 5\n"
+			"EMITTER 10 1 1 0.5 0.5 -1 1 4 5\n");
+		const auto scene = parseScene(text, 3);
+		std::stringstream binary;
+		writeBinaryScene(binary, scene.view());
+		const std::string bytes = binary.str();
+		REQUIRE(isBinaryScene(bytes.data(), bytes.size()));
+
+		const auto view = readBinaryScene(bytes.data(), bytes.size());
+		CHECK(view.info.title == "Binary");
+		CHECK(view.info.width == 640);
+		CHECK(view.info.bottomRight.y == -10);
+		REQUIRE(view.particles.size() == 5);
+		CHECK(view.particles.begin()[4].x == scene.particles[4].x);
+		REQUIRE(view.emitters.size() == 1);
+		CHECK(view.emitters.begin()[0].seed == scene.emitters[0].seed);
+
+		Simulator fromText, fromBinary;
+		addScene(scene.view(), fromText);
+		addScene(view, fromBinary);
+		CHECK(fromBinary.getLines().size() == 1);
+		REQUIRE(fromBinary.getChains().size() == 1);
+		CHECK(fromBinary.getChains()[0].getVertices().size() == 3);
+		CHECK(fromBinary.getBoxes().size() == 1);
+		CHECK(fromBinary.getBoxes()[0].h == fromText.getBoxes()[0].h);
+		CHECK(fromBinary.getBalls()[0].angVel == fromText.getBalls()[0].angVel);
+		CHECK(fromBinary.getEmitters().size() == 1);
+
+		CHECK_THROWS_AS(
+			readBinaryScene(bytes.data(), bytes.size() - 8),
+			std::invalid_argument);
+	}
+
+	SUBCASE("Parallel Parse Matches Sequential") {
+		std::ostringstream text;
+		text << "TITLE Chunks\n";
+		for (int i = 0; i < 40000; i++) {
+			text << "LINE " << i << " 0 " << i + 1 << " 1\n";
+			text << "PARTICLE 1 0.5 " << i << " 2 0.25 -1\n";
+			if (i % 1000 == 0) {
+				text << "REPEAT 3 PARTICLE 1 2 1 2 -5 5 -5 5\n";
+				text << "EMITTER 1 1 1 0.5 0.5 -1 1 4 5 0 0 0 0 1 2\n";
+			}
+		}
+		text << "END\nLINE 0 0\n";
+		const auto str = text.str();
+		const auto sequential = parseScene(str.data(), str.size(), 5, 1);
+		const auto parallel = parseScene(str.data(), str.size(), 5, 4);
+		CHECK(parallel.info.title == "Chunks");
+		REQUIRE(parallel.lines.size() == 40000);
+		REQUIRE(parallel.particles.size() == sequential.particles.size());
+		REQUIRE(parallel.emitters.size() == 40);
+		for (size_t i = 0; i < parallel.particles.size(); i++) {
+			CHECK(parallel.particles[i].x == sequential.particles[i].x);
+			CHECK(parallel.particles[i].mass == sequential.particles[i].mass);
+		}
+		CHECK(parallel.emitters[39].seed == sequential.emitters[39].seed);
+		CHECK(parallel.emitters[39].lifeMax == 2);
+
+		// Line after END is not parsed, an error in the last chunk names
+		// its line in the whole file
+		const auto body = str.substr(0, str.size() - 13);
+		const auto invalid = body + "BALL 1\n";
+		CHECK_THROWS_WITH(
+			parseScene(invalid.data(), invalid.size(), 5, 4),
+			("Failed to load scene at line " +
+			 std::to_string(std::count(body.begin(), body.end(), '\n') + 1))
+				.c_str());
+	}
+
+	SUBCASE("Invalid Line") {
+		std::istringstream scene("LINE 0 0\n");
+		CHECK_THROWS_AS(loadScene(scene, sim), std::runtime_error);
+	}
+
+	SUBCASE("Invalid Chain") {
+		std::istringstream single("CHAIN 0 0\n"), odd("CHAIN 0 0 1 1 2\n"),
+			repeated("CHAIN 1 1 1 1\n");
+		CHECK_THROWS_AS(loadScene(single, sim), std::runtime_error);
+		CHECK_THROWS_AS(loadScene(odd, sim), std::runtime_error);
+		CHECK_THROWS_AS(loadScene(repeated, sim), std::runtime_error);
+	}
+}
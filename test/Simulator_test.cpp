@@ -0,0 +1,44 @@
+#include <doctest.h>
+
+#include <PhysicsEngine2D/Simulator.hpp>
+
+TEST_CASE("Test Collision Dispatch") {
+	Simulator sim(10, 0.5f, 0.5f);
+	sim.addForceField(ForceField::makeUniform(Vector2D(0, -9.8)));
+	sim.addLine(Vector2D(-20, 0), Vector2D(20, 0));
+	const auto ball = sim.addBall(Vector2D(0, 3), Vector2D(), 2, 1);
+	const auto other = sim.addBall(Vector2D(5, 1), Vector2D(-2, 0), 1, 0.5);
+	const auto particle =
+		sim.addParticle(Vector2D(-5, 1), Vector2D(4, 0), 1, 0.5);
+	const auto box = sim.addBox(Vector2D(10, 2), Vector2D(), 1, 1, 1);
+
+	size_t contacts = 0;
+	for (int step = 0; step < 120; step++) {
+		sim.simulate(1.0f / 60);
+		contacts += sim.getStats().contacts;
+	}
+	CHECK(contacts > 0);
+	// Shapes of every type rest on the line instead of falling through
+	CHECK(sim.get(ball)->pos.y > 0.5);
+	CHECK(sim.get(other)->pos.y > 0);
+	CHECK(sim.get(particle)->pos.y > 0);
+	CHECK(sim.get(box)->pos.y > 0);
+	// Particle and small ball hit the big ball from both sides
+	CHECK(sim.get(particle)->pos.x < sim.get(ball)->pos.x);
+	CHECK(sim.get(other)->pos.x > sim.get(ball)->pos.x);
+}
+
+TEST_CASE("Test Without Substeps") {
+	// Emitters and lifetimes are handled outside the substeps, their phase
+	// times still count in the totals
+	Simulator sim(0);
+	sim.addEmitter(ParticleEmitter(
+		60, {1, 1}, {0.2, 0.2}, {-1, 1, -1, 1}, {1, 1, 0, 0}, {0.1, 0.1}));
+	const auto particle = sim.addParticle(Vector2D(), Vector2D(1, 0), 1, 0.5);
+	sim.setLifetime(particle, 0.5);
+	for (int step = 0; step < 60; step++) {
+		sim.simulate(1.0f / 60);
+	}
+	CHECK(sim.get(particle) == nullptr);
+	CHECK(sim.getStats().subStepSeconds.empty());
+}
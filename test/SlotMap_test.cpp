@@ -0,0 +1,101 @@
+#include <doctest.h>
+
+#include <PhysicsEngine2D/Simulator.hpp>
+#include <PhysicsEngine2D/SlotMap.hpp>
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+extern std::mt19937 gen;
+
+TEST_CASE("Test Slot Map") {
+	SUBCASE("Random Add And Remove") {
+		SlotMap<int> map;
+		std::vector<std::pair<Handle<int>, int>> alive;
+		std::vector<Handle<int>> removed;
+		std::uniform_int_distribution<> coin(0, 2);
+		for (int i = 0; i < 10000; i++) {
+			if (alive.empty() || coin(gen)) {
+				alive.emplace_back(map.emplace(i), i);
+			}
+			else {
+				std::uniform_int_distribution<size_t> pick(0, alive.size() - 1);
+				const size_t k = pick(gen);
+				REQUIRE(map.erase(alive[k].first));
+				removed.push_back(alive[k].first);
+				alive[k] = alive.back();
+				alive.pop_back();
+			}
+		}
+		REQUIRE(map.size() == alive.size());
+		for (auto& [handle, value] : alive) {
+			REQUIRE(map.get(handle) != nullptr);
+			CHECK(*map.get(handle) == value);
+			CHECK(map.handleOf(map.indexOf(handle)) == handle);
+		}
+		for (auto& handle : removed) {
+			CHECK(map.get(handle) == nullptr);
+			CHECK_FALSE(map.erase(handle));
+		}
+		CHECK(map.get(Handle<int>()) == nullptr);
+
+		map.clear();
+		CHECK(map.empty());
+		for (auto& [handle, value] : alive) {
+			CHECK(map.get(handle) == nullptr);
+		}
+	}
+
+	SUBCASE("Simulator Handles") {
+		Simulator sim;
+		std::vector<Handle<Particle>> particles;
+		std::vector<Handle<Line>> lines;
+		std::uniform_real_distribution<> pos(-40, 40);
+		std::uniform_int_distribution<> action(0, 3);
+
+		auto checkBaseShapes = [&]() {
+			std::set<const BaseShape*> expected, got;
+			for (auto& particle : sim.getParticles()) expected.insert(&particle);
+			for (auto& line : sim.getLines()) expected.insert(&line);
+			for (auto& shape : sim.getBaseShapes()) got.insert(&shape.get());
+			REQUIRE(sim.getBaseShapes().size() == expected.size());
+			REQUIRE(got == expected);
+		};
+
+		for (int i = 0; i < 2000; i++) {
+			const int a = action(gen);
+			if (a == 0 && !particles.empty()) {
+				std::uniform_int_distribution<size_t> pick(
+					0, particles.size() - 1);
+				const size_t k = pick(gen);
+				REQUIRE(sim.remove(particles[k]));
+				CHECK(sim.get(particles[k]) == nullptr);
+				particles[k] = particles.back();
+				particles.pop_back();
+			}
+			else if (a == 1 && !lines.empty()) {
+				REQUIRE(sim.remove(lines.back()));
+				lines.pop_back();
+			}
+			else if (a == 2) {
+				lines.push_back(sim.addLine(
+					Vector2D(pos(gen), pos(gen)), Vector2D(pos(gen), pos(gen))));
+			}
+			else {
+				const Vector2D p(pos(gen), pos(gen));
+				particles.push_back(sim.addParticle(p, Vector2D(), 1, 1));
+				CHECK(sim.get(particles.back())->pos.x == p.x);
+			}
+			if (i % 100 == 0) {
+				checkBaseShapes();
+				sim.simulate(0.01);
+			}
+		}
+		checkBaseShapes();
+		for (size_t i = 0; i < sim.getParticles().size(); i++) {
+			CHECK(
+				sim.get(sim.getHandle<Particle>(i)) == &sim.getParticles()[i]);
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#include <doctest.h>
+
+#include <PhysicsEngine2D/Simulator.hpp>
+#include <PhysicsEngine2D/StatePublisher.hpp>
+#include <string>
+#include <unistd.h>
+
+TEST_CASE("Test State Publisher") {
+	const std::string name =
+		"/PhysicsEngine2D_test_" + std::to_string(getpid());
+	Simulator sim;
+	sim.addLine(Vector2D(-20, -10), Vector2D(20, -10));
+	for (int i = 0; i < 10; i++) {
+		sim.addParticle(Vector2D(i - 5, 0), Vector2D(1, -1), 1, 0.4);
+	}
+	const auto ball = sim.addBall(Vector2D(0, 5), Vector2D(2, 0), 2, 1, 0, 0);
+	const auto box = sim.addBox(Vector2D(5, 5), Vector2D(-1, 0), 2, 1, 1);
+	sim.remove(sim.getHandle<Particle>(3));
+
+	StatePublisherOptions options;
+	options.frames = 3;
+	options.capacity = 20;
+	StatePublisher publisher(name, options);
+	SharedStateReader reader(name);
+	CHECK(reader.getCapacity() >= 20);
+	CHECK_FALSE(reader.readLatest([](const SharedStateView&) {}));
+
+	// Wrapping around the ring keeps latest frame readable
+	for (int step = 0; step < 5; step++) {
+		sim.simulate(1.0 / 60);
+		CHECK(publisher.publish(sim));
+	}
+	CHECK(reader.getPublishedFrames() == 5);
+
+	bool matches = false;
+	CHECK(reader.readLatest([&](const SharedStateView& view) {
+		matches = view.step == 4 && view.time == sim.getTime() &&
+				  view.particles == 9 && view.balls == 1 && view.boxes == 1;
+		const auto& particles = sim.getParticles();
+		for (size_t i = 0; i < particles.size(); i++) {
+			matches &= view.posX[i] == particles[i].pos.x &&
+					   view.velY[i] == particles[i].vel.y &&
+					   view.ids[i] ==
+						   sharedStateId(sim.getHandle<Particle>(i));
+		}
+		matches &= sharedStateHandle<Ball>(view.ids[9]) == ball &&
+				   sharedStateHandle<Box>(view.ids[10]) == box &&
+				   view.posY[10] == sim.get(box)->pos.y;
+	}));
+	CHECK(matches);
+
+	// Too many bodies leaves the latest frame in place
+	for (int i = 0; i < 40; i++) {
+		sim.addParticle(Vector2D(i, 10), Vector2D(), 1, 0.2);
+	}
+	CHECK_FALSE(publisher.publish(sim));
+	CHECK(reader.getPublishedFrames() == 5);
+
+	CHECK_THROWS_AS(SharedStateReader(name + "_missing"), std::runtime_error);
+}
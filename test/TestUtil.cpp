@@ -20,6 +20,66 @@ std::vector<Vector2D> getRandomPoints(
 	return points;
 }
 
+std::vector<Vector2D> getClusteredPoints(
+	const Range2D<dataType>& range2D, size_t N, size_t clusters) {
+	const auto centers = getRandomPoints(range2D, clusters);
+	const dataType halfSize =
+		0.01f * (range2D.rangeX.end - range2D.rangeX.start);
+	std::uniform_int_distribution<size_t> cluster(0, clusters - 1);
+	std::uniform_real_distribution<> offset(-halfSize, halfSize);
+	std::vector<Vector2D> points;
+	points.reserve(N);
+	for (size_t i = 0; i < N; i++) {
+		const auto& center = centers[cluster(gen)];
+		points.emplace_back(center.x + offset(gen), center.y + offset(gen));
+	}
+	return points;
+}
+
+std::vector<Vector2D> getGaussianBlobPoints(
+	const Range2D<dataType>& range2D, size_t N, size_t blobs) {
+	const auto centers = getRandomPoints(range2D, blobs);
+	const dataType sigma = 0.05f * (range2D.rangeX.end - range2D.rangeX.start);
+	std::uniform_int_distribution<size_t> blob(0, blobs - 1);
+	std::normal_distribution<> offset(0, sigma);
+	std::vector<Vector2D> points;
+	points.reserve(N);
+	for (size_t i = 0; i < N; i++) {
+		const auto& center = centers[blob(gen)];
+		points.emplace_back(
+			std::clamp<dataType>(
+				center.x + offset(gen), range2D.rangeX.start,
+				range2D.rangeX.end),
+			std::clamp<dataType>(
+				center.y + offset(gen), range2D.rangeY.start,
+				range2D.rangeY.end));
+	}
+	return points;
+}
+
+std::vector<Vector2D> getLineAlignedPoints(
+	const Range2D<dataType>& range2D, size_t N, size_t lines) {
+	const auto starts = getRandomPoints(range2D, lines),
+			   ends = getRandomPoints(range2D, lines);
+	std::uniform_int_distribution<size_t> line(0, lines - 1);
+	std::uniform_real_distribution<> param(0, 1);
+	std::vector<Vector2D> points;
+	points.reserve(N);
+	for (size_t i = 0; i < N; i++) {
+		const size_t l = line(gen);
+		auto end = ends[l];
+		// A third each of horizontal, vertical and diagonal lines
+		if (l % 3 == 0) {
+			end.y = starts[l].y;
+		}
+		else if (l % 3 == 1) {
+			end.x = starts[l].x;
+		}
+		points.emplace_back(starts[l] + param(gen) * (end - starts[l]));
+	}
+	return points;
+}
+
 std::vector<int> getShuffledArrayOf1ToN(size_t N) {
 	std::vector<int> arr(N);
 	std::iota(arr.begin(), arr.end(), 1);
@@ -10,8 +10,8 @@
 #include <PhysicsEngine2D/util.hpp>
 
 namespace std {
-	template <typename T>
-	ostream& operator<<(ostream& os, const vector<T>& in) {
+	template <typename T, typename Allocator>
+	ostream& operator<<(ostream& os, const vector<T, Allocator>& in) {
 		writeContainer(os, in);
 		return os;
 	}
@@ -25,6 +25,18 @@ namespace std {
 std::vector<Vector2D> getRandomPoints(
 	const Range2D<dataType>& range2D, size_t N);
 
+// Points in small uniform squares around random centers
+std::vector<Vector2D> getClusteredPoints(
+	const Range2D<dataType>& range2D, size_t N, size_t clusters = 32);
+
+// Points normally distributed around random centers, clamped to range2D
+std::vector<Vector2D> getGaussianBlobPoints(
+	const Range2D<dataType>& range2D, size_t N, size_t blobs = 8);
+
+// Points on random horizontal, vertical and diagonal segments
+std::vector<Vector2D> getLineAlignedPoints(
+	const Range2D<dataType>& range2D, size_t N, size_t lines = 64);
+
 std::vector<int> getShuffledArrayOf1ToN(size_t N);
 Range2D<dataType> getRandom2DRange(
 	const Range2D<dataType>& positionRange, const Range2D<dataType>& sizeRange);
@@ -61,10 +73,10 @@ struct IntervalTreeCollision {
 	}
 };
 
-// template <typename Tree> struct RangeQueryCollision {
-// 	static auto getCollisions(
-// 		const std::vector<std::reference_wrapper<BaseShape>> &objects) {
-// 		return getCollisionRangeQuery<Tree>(objects);
-// 	}
-// };
+template <typename Tree> struct RangeQueryCollision {
+	static auto getCollisions(
+		const std::vector<std::reference_wrapper<BaseShape>>& objects) {
+		return getCollisionRangeQuery<Tree>(objects);
+	}
+};
 #endif	// TEST_UTIL_HPP
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include <doctest.h>
+
+#include <PhysicsEngine2D/TraceRecorder.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static size_t countOccurrences(const std::string& text, const std::string& s) {
+	size_t count = 0;
+	for (size_t pos = text.find(s); pos != std::string::npos;
+		 pos = text.find(s, pos + 1)) {
+		count++;
+	}
+	return count;
+}
+
+TEST_CASE("Test Trace Recorder") {
+	SUBCASE("Events Of Each Thread") {
+		TraceRecorder recorder;
+		const int threadCount = 4, scopes = 100;
+		std::vector<std::thread> threads;
+		for (int t = 0; t < threadCount; t++) {
+			threads.emplace_back([&]() {
+				for (int i = 0; i < scopes; i++) {
+					ScopedTrace outer(&recorder, "Outer");
+					ScopedTrace inner(&recorder, "Inner");
+				}
+			});
+		}
+		for (auto& thread : threads) thread.join();
+
+		std::stringstream out;
+		recorder.writeChromeTrace(out);
+		const auto json = out.str();
+		CHECK(countOccurrences(json, "\"ph\":\"B\"") == threadCount * scopes * 2);
+		CHECK(countOccurrences(json, "\"ph\":\"E\"") == threadCount * scopes * 2);
+		for (int t = 1; t <= threadCount; t++) {
+			CHECK(
+				countOccurrences(json, "\"tid\":" + std::to_string(t) + ",") ==
+				scopes * 4);
+		}
+
+		recorder.clear();
+		std::stringstream empty;
+		recorder.writeChromeTrace(empty);
+		CHECK(countOccurrences(empty.str(), "\"ph\"") == 0);
+	}
+
+	SUBCASE("Wrapped Ring Drops Unmatched Ends") {
+		TraceRecorder recorder(8);
+		for (int i = 0; i < 4; i++) recorder.begin("Outer");
+		for (int i = 0; i < 10; i++) {
+			ScopedTrace inner(&recorder, "Inner");
+		}
+		for (int i = 0; i < 4; i++) recorder.end("Outer");
+
+		// Ring keeps last 8 events: 2 inner pairs and 4 outer ends
+		std::stringstream out;
+		recorder.writeChromeTrace(out);
+		const auto json = out.str();
+		CHECK(countOccurrences(json, "\"ph\":\"B\"") == 2);
+		CHECK(countOccurrences(json, "\"ph\":\"E\"") == 2);
+		CHECK(countOccurrences(json, "Outer") == 0);
+	}
+}
@@ -0,0 +1,129 @@
+#include <doctest.h>
+
+#include <PhysicsEngine2D/Simulator.hpp>
+#include <PhysicsEngine2D/TrajectoryRecorder.hpp>
+#include <cmath>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+static bool framesMatch(
+	const TrajectoryFrame& a, const TrajectoryFrame& b,
+	const TrajectoryQuanta& quanta) {
+	if (a.step != b.step || a.time != b.time || a.particles != b.particles ||
+		a.balls != b.balls || a.boxes != b.boxes || a.size() != b.size()) {
+		return false;
+	}
+	for (int f = 0; f < TRAJECTORY_FIELD_COUNT; f++) {
+		const double tolerance = quanta.of(TrajectoryField(f));
+		for (size_t i = 0; i < a.size(); i++) {
+			if (std::abs(a.fields[f][i] - b.fields[f][i]) > tolerance) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static void fillSimulator(Simulator& sim) {
+	sim.addLine(Vector2D(-20, -10), Vector2D(20, -10));
+	for (int i = 0; i < 20; i++) {
+		sim.addParticle(Vector2D(i - 10, 5), Vector2D(0.5, -1), 1, 0.4);
+	}
+	sim.addBall(Vector2D(0, 0), Vector2D(1, 2), 2, 1, 0.5, 1);
+	sim.addBox(Vector2D(5, 0), Vector2D(-1, 0), 2, 1.5, 0.5, 0.25, -1);
+	sim.addForceField(ForceField([](const DynamicShape& a, const ForceField&) {
+		return Vector2D(0, -9.8) * a.mass;
+	}));
+}
+
+TEST_CASE("Test Trajectory") {
+	const TrajectoryQuanta quanta;
+
+	SUBCASE("Encode And Decode") {
+		Simulator sim;
+		fillSimulator(sim);
+		TrajectoryEncoder encoder(quanta);
+		TrajectoryDecoder decoder(quanta);
+		std::vector<TrajectoryFrame> frames(4);
+		std::vector<uint8_t> data;
+		for (size_t i = 0; i < frames.size(); i++) {
+			// Changed body count forces a frame encoded on its own
+			if (i == 2) {
+				sim.addParticle(Vector2D(0, 8), Vector2D(), 1, 0.5);
+			}
+			sim.simulate(1.0 / 60);
+			frames[i].capture(sim, i);
+			encoder.encode(frames[i], data);
+		}
+		CHECK(frames[0].particles == 20);
+		CHECK(frames[3].particles == 21);
+		CHECK(frames[3].fields[SIZE_X][22] == doctest::Approx(1.5));
+
+		TrajectoryFrame decoded;
+		const uint8_t* position = data.data();
+		for (const auto& frame : frames) {
+			position = decoder.decode(position, data.data() + data.size(), decoded);
+			CHECK(framesMatch(decoded, frame, quanta));
+		}
+		CHECK(position == data.data() + data.size());
+		CHECK_THROWS_AS(
+			decoder.decode(data.data(), data.data() + 12, decoded),
+			std::invalid_argument);
+	}
+
+	SUBCASE("Record And Read") {
+		const auto path =
+			std::filesystem::temp_directory_path() / "Trajectory_test.pe2t";
+		Simulator sim;
+		fillSimulator(sim);
+		TrajectoryOptions options;
+		options.stride = 2;
+		options.framesPerChunk = 3;
+		std::vector<TrajectoryFrame> expected;
+		{
+			TrajectoryRecorder recorder(path, options);
+			for (int step = 0; step < 20; step++) {
+				sim.simulate(1.0 / 60);
+				recorder.record(sim);
+				if (step % 2 == 0) {
+					expected.emplace_back().capture(sim, step);
+				}
+				// Let writer keep up, so no frame is dropped
+				while (recorder.getRecordedFrames() < expected.size()) {
+					std::this_thread::yield();
+				}
+			}
+			recorder.close();
+			CHECK(recorder.getDroppedFrames() == 0);
+		}
+
+		TrajectoryFrame frame;
+		{
+			TrajectoryReader reader(path);
+			REQUIRE(reader.getFrameCount() == expected.size());
+			CHECK(reader.getStride() == 2);
+			for (size_t i = 0; i < expected.size(); i++) {
+				reader.readFrame(i, frame);
+				CHECK(framesMatch(frame, expected[i], quanta));
+			}
+			// Random access decodes from start of chunk
+			reader.readFrame(7, frame);
+			CHECK(framesMatch(frame, expected[7], quanta));
+			reader.readFrame(2, frame);
+			CHECK(framesMatch(frame, expected[2], quanta));
+			CHECK_THROWS_AS(reader.readFrame(10, frame), std::out_of_range);
+		}
+
+		// Without index, complete chunks are found by scanning
+		const auto size = std::filesystem::file_size(path);
+		std::filesystem::resize_file(
+			path, size - sizeof(TrajectoryFileFooter) -
+					  4 * sizeof(TrajectoryIndexEntry) - 1);
+		TrajectoryReader truncated(path);
+		CHECK(truncated.getFrameCount() == 9);
+		truncated.readFrame(8, frame);
+		CHECK(framesMatch(frame, expected[8], quanta));
+		std::filesystem::remove(path);
+	}
+}
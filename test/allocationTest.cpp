@@ -0,0 +1,45 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest.h>
+
+#include <PhysicsEngine2D/Emitter.hpp>
+#include <PhysicsEngine2D/Simulator.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Replaces the allocator of the whole program, so these checks run in their
+// own executable instead of with the other tests
+static std::atomic<size_t> allocations{0};
+
+void* operator new(size_t size) {
+	allocations++;
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+TEST_CASE("Test Steady State Does Not Allocate") {
+	Simulator sim(10, 0.9f, 0.9f);
+	sim.addForceField(ForceField([](const DynamicShape& a, const ForceField&) {
+		return Vector2D(0, -9.8f) * a.mass;
+	}));
+	sim.addLine(Vector2D(-50, -10), Vector2D(50, -10));
+	sim.addEmitter(ParticleEmitter(
+		120, {1, 1}, {0.25, 0.5}, {-5, 5, 0, 5}, {-1, 1, 0, 1}, {1, 1}, 7));
+
+	// Warm up until lifetimes start to expire and capacities settle
+	const float dt = 1.0f / 60;
+	for (int step = 0; step < 330; step++) {
+		sim.simulate(dt);
+	}
+
+	const size_t before = allocations;
+	size_t spawned = 0;
+	for (int step = 0; step < 120; step++) {
+		sim.simulate(dt);
+		spawned += sim.getStats().spawned;
+	}
+	CHECK(spawned > 200);
+	CHECK(allocations == before);
+}
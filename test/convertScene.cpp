@@ -0,0 +1,42 @@
+#include <PhysicsEngine2D/Scene.hpp>
+#include <PhysicsEngine2D/util.hpp>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+static void printUsage(const char* program) {
+	std::cerr << "Usage: " << program << " INPUT OUTPUT [--seed N]\n"
+			  << "Converts a text scene to the binary scene format, REPEAT\n"
+			  << "items are expanded with the given seed (default 42)\n";
+}
+
+int main(int argc, char** argv) {
+	if (argc != 3 && !(argc == 5 && std::string(argv[3]) == "--seed")) {
+		printUsage(argv[0]);
+		return 1;
+	}
+	try {
+		const uint32_t seed = argc == 5 ? std::stoul(argv[4]) : 42;
+		std::ifstream in(argv[1]);
+		if (!in) {
+			throw std::invalid_argument(
+				"Unable to open scene file " + std::string(argv[1]));
+		}
+		const auto scene = parseScene(in, seed);
+		std::ofstream out(argv[2], std::ios::binary);
+		writeBinaryScene(out, scene.view());
+		if (!out) {
+			throw std::runtime_error("Failed to write " + std::string(argv[2]));
+		}
+		std::cout << "Wrote " << scene.lines.size() << " lines, "
+				  << scene.chains.size() << " chains, "
+				  << scene.particles.size() << " particles, "
+				  << scene.balls.size() << " balls, " << scene.boxes.size()
+				  << " boxes, " << scene.emitters.size() << " emitters\n";
+	}
+	catch (const std::exception& e) {
+		print_exception(e);
+		return 1;
+	}
+	return 0;
+}
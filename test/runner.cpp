@@ -0,0 +1,233 @@
+#include <PhysicsEngine2D/Scene.hpp>
+#include <PhysicsEngine2D/Simulator.hpp>
+#include <PhysicsEngine2D/StatePublisher.hpp>
+#include <PhysicsEngine2D/Stats.hpp>
+#include <PhysicsEngine2D/TraceRecorder.hpp>
+#include <PhysicsEngine2D/TrajectoryRecorder.hpp>
+#include <PhysicsEngine2D/util.hpp>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+static void printUsage(const char* program) {
+	std::cerr
+		<< "Usage: " << program << " SCENE [options]\n"
+		<< "Runs a scene without a display and prints throughput\n\n"
+		<< "  --steps N      number of steps (default 1000)\n"
+		<< "  --dt SECONDS   simulated time per step (default 1/60)\n"
+		<< "  --substeps N   substeps per step (default 10)\n"
+		<< "  --seed N       seed for REPEAT items (default 42)\n"
+		<< "  --dump FILE    write final state in scene format\n"
+		<< "  --trace FILE   write Chrome trace of every step\n"
+		<< "  --record FILE  write compressed trajectory of the run\n"
+		<< "  --record-every N  steps between recorded frames (default 1)\n"
+		<< "  --publish NAME publish state of every step to shared memory\n";
+}
+
+/**
+ * Parses whole value as a T, unlike std::stoul a sign or a value out of the
+ * range of T is rejected instead of wrapping around
+ */
+template <class T> static T parseUnsigned(const std::string& value) {
+	T result;
+	const auto end = value.data() + value.size();
+	const auto [ptr, ec] = std::from_chars(value.data(), end, result);
+	if (ec != std::errc() || ptr != end) {
+		throw std::invalid_argument("Invalid count " + value);
+	}
+	return result;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	std::string scenePath = argv[1], dumpPath, tracePath, recordPath,
+				publishName;
+	unsigned long steps = 1000, subSteps = 10, seed = 42, recordStride = 1;
+	double dt = 1.0 / 60;
+	try {
+		for (int i = 2; i < argc; i++) {
+			const std::string arg = argv[i];
+			if (i + 1 >= argc) {
+				throw std::invalid_argument("Missing value for " + arg);
+			}
+			const std::string value = argv[++i];
+			if (arg == "--steps") {
+				steps = parseUnsigned<unsigned long>(value);
+			}
+			else if (arg == "--dt") {
+				dt = std::stod(value);
+			}
+			else if (arg == "--substeps") {
+				subSteps = parseUnsigned<unsigned>(value);
+			}
+			else if (arg == "--seed") {
+				seed = parseUnsigned<uint32_t>(value);
+			}
+			else if (arg == "--dump") {
+				dumpPath = value;
+			}
+			else if (arg == "--trace") {
+				tracePath = value;
+			}
+			else if (arg == "--record") {
+				recordPath = value;
+			}
+			else if (arg == "--record-every") {
+				recordStride = parseUnsigned<unsigned>(value);
+			}
+			else if (arg == "--publish") {
+				publishName = value;
+			}
+			else {
+				throw std::invalid_argument("Unknown option " + arg);
+			}
+		}
+		if (steps < 1 || subSteps < 1 || !(dt > 0)) {
+			throw std::invalid_argument(
+				"Steps and substeps must be at least 1 and dt positive");
+		}
+	}
+	catch (const std::exception& e) {
+		print_exception(e);
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	Simulator sim(subSteps, 0.9f, 0.9f);
+	SceneInfo info;
+	try {
+		info = loadScene(scenePath, sim, seed);
+	}
+	catch (const std::exception& e) {
+		print_exception(e);
+		return 1;
+	}
+
+	// Trace of a long run only keeps its last events
+	std::unique_ptr<TraceRecorder> traceRecorder;
+	if (!tracePath.empty()) {
+		traceRecorder = std::make_unique<TraceRecorder>(1 << 20);
+		sim.setTraceRecorder(traceRecorder.get());
+	}
+
+	std::unique_ptr<TrajectoryRecorder> trajectoryRecorder;
+	if (!recordPath.empty()) {
+		TrajectoryOptions options;
+		options.stride = recordStride;
+		try {
+			trajectoryRecorder =
+				std::make_unique<TrajectoryRecorder>(recordPath, options);
+		}
+		catch (const std::exception& e) {
+			print_exception(e);
+			return 1;
+		}
+	}
+
+	std::unique_ptr<StatePublisher> statePublisher;
+	if (!publishName.empty()) {
+		try {
+			statePublisher = std::make_unique<StatePublisher>(publishName);
+		}
+		catch (const std::exception& e) {
+			print_exception(e);
+			return 1;
+		}
+	}
+
+	// Emitters change number of bodies while running
+	size_t bodySteps = 0;
+	PhaseTimes phaseSeconds{};
+	size_t candidatePairs = 0, contacts = 0, impulses = 0, spawned = 0,
+		   expired = 0;
+
+	const auto start = std::chrono::steady_clock::now();
+	for (unsigned long step = 0; step < steps; step++) {
+		sim.simulate(dt);
+		if (trajectoryRecorder) {
+			trajectoryRecorder->record(sim);
+		}
+		if (statePublisher) {
+			statePublisher->publish(sim);
+		}
+		bodySteps += sim.getBaseShapes().size();
+		const auto& stats = sim.getStats();
+		for (int phase = 0; phase < PHASE_COUNT; phase++) {
+			phaseSeconds[phase] += stats.totalSeconds[phase];
+		}
+		candidatePairs += stats.candidatePairs;
+		contacts += stats.contacts;
+		impulses += stats.impulses;
+		spawned += stats.spawned;
+		expired += stats.expired;
+	}
+	const double seconds =
+		std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+			.count();
+
+	std::printf("Scene: %s\n", info.title.c_str());
+	std::printf(
+		"Bodies: %zu, Steps: %lu, dt: %g s, Substeps: %lu\n",
+		sim.getBaseShapes().size(), steps, dt, subSteps);
+	std::printf("Wall time: %.3f s\n", seconds);
+	std::printf("Steps/s: %.1f\n", steps / seconds);
+	std::printf("Bodies*Steps/s: %.1f\n", bodySteps / seconds);
+
+	double phaseTotal = 0;
+	for (auto phaseTime : phaseSeconds) phaseTotal += phaseTime;
+	std::printf("\n%-14s %12s %8s\n", "Phase", "ms/step", "share");
+	for (int phase = 0; phase < PHASE_COUNT; phase++) {
+		std::printf(
+			"%-14s %12.4f %7.1f%%\n", getPhaseName(SimulationPhase(phase)),
+			1000 * phaseSeconds[phase] / std::max(1ul, steps),
+			phaseTotal > 0 ? 100 * phaseSeconds[phase] / phaseTotal : 0);
+	}
+	std::printf(
+		"\nPer step: %.1f candidate pairs, %.1f contacts, %.1f impulses\n",
+		double(candidatePairs) / std::max(1ul, steps),
+		double(contacts) / std::max(1ul, steps),
+		double(impulses) / std::max(1ul, steps));
+	if (spawned || expired) {
+		std::printf("Spawned: %zu, Expired: %zu\n", spawned, expired);
+	}
+
+	if (!dumpPath.empty()) {
+		std::ofstream dump(dumpPath);
+		writeScene(dump, sim);
+		if (!dump) {
+			std::cerr << "Failed to write " << dumpPath << "\n";
+			return 1;
+		}
+	}
+	if (trajectoryRecorder) {
+		try {
+			trajectoryRecorder->close();
+		}
+		catch (const std::exception& e) {
+			print_exception(e);
+			return 1;
+		}
+		std::printf(
+			"Recorded %zu frames, dropped %zu\n",
+			trajectoryRecorder->getRecordedFrames(),
+			trajectoryRecorder->getDroppedFrames());
+	}
+	if (traceRecorder) {
+		std::ofstream trace(tracePath);
+		traceRecorder->writeChromeTrace(trace);
+		if (!trace) {
+			std::cerr << "Failed to write " << tracePath << "\n";
+			return 1;
+		}
+	}
+	return 0;
+}